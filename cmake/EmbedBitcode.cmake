@@ -0,0 +1,12 @@
+# Writes the bitcode file INPUT to OUTPUT as a C++ byte array named SYMBOL,
+# plus SYMBOL##Size. Run with cmake -P at build time.
+file(READ "${INPUT}" content HEX)
+string(LENGTH "${content}" hexLength)
+math(EXPR size "${hexLength} / 2")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${content}")
+
+file(WRITE "${OUTPUT}"
+  "// Generated from ${INPUT}; do not edit\n"
+  "#include <cstddef>\n\n"
+  "alignas(4) extern const unsigned char ${SYMBOL}[] = {${bytes}};\n"
+  "extern const size_t ${SYMBOL}Size = ${size};\n")
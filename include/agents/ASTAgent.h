@@ -2,10 +2,14 @@
 
 #include "ast/Stmt.h"
 #include <memory>
+#include <string>
 
 class ASTAgent {
 public:
     static void validateAST(ast::Program* program);
     static void dumpAST(ast::Program* program, int indent = 0);
+    // Canonical text of a function's signature and body; source positions are
+    // left out so reformatting does not change it
+    static std::string fingerprint(ast::Function* func);
 };
 
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "agents/InvocationAgent.h"
+#include "ast/Stmt.h"
+#include <string>
+#include <vector>
+
+// Evaluates one compiled DSL function over many argument tuples through its
+// entry trampoline (see InvocationAgent)
+class BatchAgent {
+private:
+    EntryTrampoline entry;
+    std::string name;
+    ast::Type returnType;
+    std::vector<ast::Type> paramTypes;
+    
+    bool parseTuple(const std::vector<std::string>& fields, InvocationSlot* slots, const std::string& where) const;
+    
+public:
+    BatchAgent(EntryTrampoline entry, const ast::Function& signature);
+    
+    size_t getArity() const { return paramTypes.size(); }
+    
+    // Argument text to slots, checked against the signature
+    bool parseArguments(const std::vector<std::string>& args, std::vector<InvocationSlot>& slots) const;
+    
+    // Argument tuples, one slot per parameter, row after row. A .bin file holds
+    // packed 8-byte slots; anything else is CSV with one tuple per line
+    bool readInputs(const std::string& filename, std::vector<InvocationSlot>& inputs) const;
+    
+    // Calls the function once per tuple; rows are split into contiguous
+    // chunks across threads
+    void run(const std::vector<InvocationSlot>& inputs, std::vector<InvocationSlot>& results,
+             unsigned threads) const;
+    
+    // .bin writes packed slots; otherwise one formatted value per line (stdout if filename is empty)
+    bool writeResults(const std::string& filename, const std::vector<InvocationSlot>& results) const;
+};
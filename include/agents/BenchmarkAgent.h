@@ -0,0 +1,52 @@
+#pragma once
+
+#include "agents/PerfCounterAgent.h"
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-iteration times in nanoseconds and their summary
+struct BenchmarkResult {
+    std::string name;
+    // "tsc" (invariant time-stamp counter) or "steady_clock"
+    std::string clock;
+    unsigned warmup = 0;
+    std::vector<double> samples;
+    double min = 0, median = 0, p90 = 0, p99 = 0, mean = 0, stddev = 0;
+};
+
+// Times compiled code: calls into JITed (or JIT-loaded AOT) functions in-process,
+// or whole runs of a linked executable. The thread is pinned to its current CPU
+// while measuring
+class BenchmarkAgent {
+private:
+    unsigned iterations;
+    unsigned warmup;
+    PerfCounterAgent* counters = nullptr;
+    
+    static void summarize(BenchmarkResult& result);
+    
+public:
+    BenchmarkAgent(unsigned iterations, unsigned warmup);
+    
+    // Counted over the timed calls of measure() (clock reads included)
+    void setCounters(PerfCounterAgent* perfCounters) { counters = perfCounters; }
+    
+    // One sample per call. The clock's own cost is measured first and subtracted
+    BenchmarkResult measure(const std::string& name, llvm::function_ref<void()> call) const;
+    // One sample per process run, so process startup is included
+    bool measureExecutable(const std::string& path, BenchmarkResult& result) const;
+    
+    // Keeps the compiler from treating a result as unused or hoisting the call
+    // that produced it
+    static void doNotOptimize(const void* value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r"(value) : "memory");
+#endif
+    }
+    
+    static void printText(const BenchmarkResult& result);
+    // "-" writes to stdout
+    static bool writeJSON(const BenchmarkResult& result, const std::string& filename);
+};
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Support/CodeGen.h>
 #include <llvm/Support/raw_ostream.h>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 enum class OutputFormat {
     Object,
@@ -18,16 +22,50 @@ class CodegenAgent {
 private:
     std::string targetTriple;
     std::unique_ptr<llvm::TargetMachine> targetMachine;
+    bool hotColdSplitting = false;
+    bool positionIndependent = false;
     
+    std::unique_ptr<llvm::TargetMachine> createTargetMachine() const;
     bool initializeTarget();
     
 public:
     CodegenAgent();
     
+    // Put each function in its own section and split cold blocks out (needs profile data).
+    // Must be set before the first emission: the target machine is created once per agent
+    void setHotColdSplitting(bool enable) { hotColdSplitting = enable; }
+    // PIC code for shared libraries; same caveat as above
+    void setPositionIndependent(bool enable) { positionIndependent = enable; }
+    
+    // Format implied by a file's extension (.ll, .bc, .s), defaulting to object code
+    static OutputFormat formatForFilename(const std::string& filename);
+    // Swap a known output extension on filename for the one matching format
+    static std::string filenameForFormat(const std::string& filename, OutputFormat format);
+    
+    // Emit into memory; the buffer can be written out or handed to the linker/JIT
+    bool emitToBuffer(llvm::Module* module, OutputFormat format, llvm::SmallVectorImpl<char>& buffer);
+    static bool writeBuffer(const std::string& filename, llvm::StringRef data);
+    
+    // Emit several formats from one session. IR-level outputs are taken first,
+    // then an object split over objectThreads (splitting only reads the module,
+    // though it gives local symbols hidden linkage). Assembly and a serial
+    // object each need a backend run of their own, which rewrites the module in
+    // place, so all but the last work on a copy. objectFiles receives the
+    // objects written: the object output, or its partitions
+    bool emitOutputs(llvm::Module* module,
+                     const std::vector<std::pair<OutputFormat, std::string>>& outputs,
+                     std::vector<std::string>& objectFiles, unsigned objectThreads = 1);
+    
     bool emitObjectFile(llvm::Module* module, const std::string& filename);
+    // Split the module and run instruction selection/emission for each part on its own thread
+    bool emitObjectFilesParallel(llvm::Module* module, const std::string& filename,
+                                 unsigned numThreads, std::vector<std::string>& objectFiles);
     bool emitAssemblyFile(llvm::Module* module, const std::string& filename);
     bool emitBitcodeFile(llvm::Module* module, const std::string& filename);
     bool emitIRFile(llvm::Module* module, const std::string& filename);
+    bool emitSymbolOrderingFile(llvm::Module* module, const std::string& filename);
+    // C declarations for every exported function, for hosts linking the library
+    bool emitCHeader(llvm::Module* module, const std::string& filename);
     
     bool emit(llvm::Module* module, const std::string& filename, OutputFormat format);
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/CachePruning.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Persistent content-addressed cache of object files shared between compiler runs
+class CompileCacheAgent {
+private:
+    std::string cacheDir;
+    llvm::CachePruningPolicy policy;
+
+    std::string entryPath(const std::string& key) const;
+    std::string statsPath() const;
+    void recordEvent(bool hit);
+    void touch(const std::string& path);
+
+public:
+    CompileCacheAgent(const std::string& cacheDir, uint64_t maxSizeBytes);
+
+    bool initialize();
+
+    // Key over every input that can change the object: sources, effective flags,
+    // target triple and the LLVM version the compiler was built against
+    static std::string computeKey(const std::vector<std::string>& sources,
+                                  const std::vector<std::string>& flags,
+                                  const std::string& triple);
+
+    // Copy the cached object to outputFile; counts a hit or a miss
+    bool lookup(const std::string& key, const std::string& outputFile);
+    // Insert atomically: write a temporary file in the cache, then rename it into place
+    bool store(const std::string& key, const std::string& objectFile);
+
+    // Raw entries for other artifacts (e.g. per-function IR); not counted in the stats
+    std::unique_ptr<llvm::MemoryBuffer> lookupBuffer(const std::string& key);
+    bool storeBuffer(const std::string& key, llvm::StringRef data);
+
+    // Size-bounded LRU eviction
+    void prune();
+
+    CacheStats getStats() const;
+    void printStats() const;
+};
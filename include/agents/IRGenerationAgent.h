@@ -1,11 +1,14 @@
 #pragma once
 
 #include "ast/Stmt.h"
+#include "ast/CallGraph.h"
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 class IRGenerationAgent {
 private:
@@ -13,6 +16,9 @@ private:
     std::unique_ptr<llvm::IRBuilder<>> builder;
     std::unique_ptr<llvm::Module> module;
     std::unordered_map<std::string, llvm::Value*> namedValues;
+    size_t errorCount = 0;
+    
+    void reportError(const std::string& message);
     
     llvm::Value* codegenExpr(ast::Expr* expr);
     llvm::Value* codegenBinaryExpr(ast::BinaryExpr* expr);
@@ -26,11 +32,34 @@ private:
     void codegenLet(ast::LetStmt* stmt);
     
     llvm::Function* codegenFunction(ast::Function* func);
+    void inferAttributes(const ast::CallGraph& callGraph);
     
 public:
-    IRGenerationAgent(llvm::LLVMContext& ctx);
+    IRGenerationAgent(llvm::LLVMContext& ctx, const std::string& moduleName = "DSL_Module");
+    
+    // Declare a function defined elsewhere (another input file) so calls to it resolve
+    llvm::Function* declareFunction(ast::Function* func);
     
-    void generate(ast::Program* program);
+    // Prototypes for the functions an LLVM module defines whose signatures use
+    // DSL types, so DSL code can call into IR inputs and libraries
+    static std::vector<std::unique_ptr<ast::Function>> importPrototypes(const llvm::Module& module);
+    
+    // Declares every prototype first, then lowers bodies bottom-up over the call graph
+    bool generate(ast::Program* program);
     llvm::Module* getModule() { return module.get(); }
+    std::unique_ptr<llvm::Module> takeModule() { return std::move(module); }
+    
+    // Lower the program on a thread pool: each shard gets its own context and
+    // declares every function it does not define as an external prototype.
+    // Empty if any function failed to lower
+    static std::vector<llvm::orc::ThreadSafeModule> generateShards(
+        ast::Program* program, const std::vector<ast::Function*>& externals,
+        const std::string& moduleName, unsigned numShards);
+    static std::unique_ptr<llvm::Module> linkShards(
+        std::vector<llvm::orc::ThreadSafeModule>& shards, llvm::LLVMContext& ctx,
+        const std::string& moduleName);
+    static std::unique_ptr<llvm::Module> generateParallel(
+        ast::Program* program, const std::vector<ast::Function*>& externals,
+        llvm::LLVMContext& ctx, const std::string& moduleName, unsigned numThreads);
 };
 
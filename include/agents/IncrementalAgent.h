@@ -0,0 +1,38 @@
+#pragma once
+
+#include "agents/CompileCacheAgent.h"
+#include "ast/Stmt.h"
+#include <llvm/IR/Module.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Function-granular incremental compilation on top of the compile cache.
+// Each function is keyed on its own AST and the ASTs of everything it can call,
+// so editing a function invalidates it and every caller that may have inlined it.
+class IncrementalAgent {
+private:
+    CompileCacheAgent& cache;
+    std::vector<std::string> flags;
+    std::string triple;
+    std::unordered_map<std::string, std::string> functionKeys;
+    std::map<std::string, std::unique_ptr<llvm::Module>> cachedFunctions;
+    size_t reusedCount = 0;
+
+public:
+    IncrementalAgent(CompileCacheAgent& cache, std::vector<std::string> flags, std::string triple);
+
+    void computeKeys(const std::vector<ast::Program*>& programs);
+
+    // Before optimization: functions with a cached optimized body become
+    // available_externally, so dirty callers can still inline them
+    void prepare(llvm::Module* module);
+
+    // After optimization: cache every freshly optimized function, then replace
+    // the clean ones with their cached definitions
+    bool finish(llvm::Module* module);
+
+    size_t getReusedCount() const { return reusedCount; }
+};
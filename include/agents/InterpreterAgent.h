@@ -0,0 +1,104 @@
+#pragma once
+
+#include "agents/InvocationAgent.h"
+#include "ast/Stmt.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class InterpMode {
+    Off,
+    Always,
+    Auto
+};
+
+// Runs DSL programs straight from the AST, without building IR. Functions are
+// first resolved into a compact tree (variables become frame slots, calls point
+// at their callee, every node carries its type), so evaluation does no name
+// lookups. Integer arithmetic wraps and comparisons are signed, as in the
+// generated IR; standard library calls run natively
+class InterpreterAgent {
+public:
+    // Evaluations above this count are run by the JIT under --interp=auto
+    static constexpr uint64_t DefaultCutoff = 1000000;
+    
+private:
+    enum class NodeKind : uint8_t {
+        Constant,
+        Variable,
+        Binary,
+        Unary,
+        Call,
+        Native
+    };
+    
+    struct Node {
+        NodeKind kind;
+        uint8_t op = 0;
+        // Type the node produces, and the type its operands are evaluated in
+        ast::Type::Kind type;
+        ast::Type::Kind operandType;
+        // Frame slot, callee or native function
+        uint32_t index = 0;
+        // Binary and unary operands are nodes; call arguments are operands[first, first + count)
+        uint32_t lhs = 0, rhs = 0;
+        uint32_t first = 0, count = 0;
+        InvocationSlot constant = {};
+    };
+    
+    // Let binds slot; a return without a value has no node
+    struct Step {
+        bool isReturn;
+        uint32_t slot;
+        int32_t node;
+    };
+    
+    struct CompiledFunction {
+        const ast::Function* source;
+        std::vector<Node> nodes;
+        std::vector<uint32_t> operands;
+        std::vector<Step> steps;
+        uint32_t frameSize = 0;
+    };
+    
+    using NativeFunction = InvocationSlot (*)(const InvocationSlot* args);
+    struct Native {
+        const char* name;
+        ast::Type::Kind returnType;
+        std::vector<ast::Type::Kind> params;
+        NativeFunction call;
+    };
+    
+    static const std::vector<Native>& natives();
+    
+    std::vector<CompiledFunction> functions;
+    std::map<std::string, uint32_t> functionIndex;
+    // Frames of active calls; indexed, since calls grow it
+    std::vector<InvocationSlot> stack;
+    unsigned depth = 0;
+    
+    bool compile(CompiledFunction& function);
+    int32_t compileExpr(CompiledFunction& function, const ast::Expr* expr,
+                        const std::map<std::string, std::pair<uint32_t, ast::Type::Kind>>& scope);
+    uint64_t cost(uint32_t function, std::vector<int>& state, std::vector<uint64_t>& memo) const;
+    
+    InvocationSlot invoke(uint32_t function, size_t frame);
+    InvocationSlot eval(const CompiledFunction& function, uint32_t node, size_t frame);
+    
+public:
+    // Resolves every function; false (with the error logged) if any would not
+    // compile, such as mismatched operand types or an unknown name
+    bool load(const std::vector<std::unique_ptr<ast::Program>>& programs);
+    
+    const ast::Function* getFunction(const std::string& name) const;
+    
+    // Nodes evaluated by one call, callees included. Recursive functions never
+    // return (the language has no branches), so they are reported as UINT64_MAX
+    uint64_t estimateCost(const std::string& name) const;
+    
+    // False on a runtime error: division by zero, overflowing division or
+    // exceeding the call depth limit
+    bool call(const std::string& name, const std::vector<InvocationSlot>& args, InvocationSlot& result);
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ast/ASTNode.h"
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <cstdint>
+#include <string>
+
+// One argument or return value. Every value lives at offset 0 of an 8-byte slot,
+// so a trampoline can load it with its own type on any byte order
+union InvocationSlot {
+    bool b;
+    int32_t i32;
+    int64_t i64;
+    float f32;
+    double f64;
+};
+static_assert(sizeof(InvocationSlot) == 8, "invocation slots are 8 bytes");
+
+// void __dsl_entry_<fn>(const InvocationSlot* args, InvocationSlot* result)
+using EntryTrampoline = void (*)(const InvocationSlot* args, InvocationSlot* result);
+
+// Calls into compiled DSL functions through generated typed trampolines, so the
+// host needs no per-signature function pointer types
+class InvocationAgent {
+public:
+    static constexpr const char* TrampolinePrefix = "__dsl_entry_";
+    
+    static std::string trampolineName(const std::string& function);
+    
+    // Trampoline that unpacks the argument slots, calls the target and stores its result
+    static llvm::Function* createTrampoline(llvm::Function* target);
+    // Trampolines for every externally visible function defined in the module
+    static void createTrampolines(llvm::Module* module);
+    
+    static bool parseValue(const std::string& text, ast::Type type, InvocationSlot& slot);
+    static std::string formatValue(const InvocationSlot& slot, ast::Type type);
+};
@@ -1,23 +1,80 @@
 #pragma once
 
+#include "agents/JITCacheAgent.h"
+#include "agents/TierUpAgent.h"
 #include <llvm/IR/Module.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 class JITAgent {
 private:
     std::unique_ptr<llvm::orc::LLJIT> jit;
-    llvm::LLVMContext context;
+    // Set when jit is an LLLazyJIT
+    llvm::orc::LLLazyJIT* lazyJit = nullptr;
+    bool lazy = false;
+    int lazyOptLevel = 2;
+    // Declared after jit so its compile thread stops before the JIT goes away
+    std::unique_ptr<TierUpAgent> tiers;
+    uint64_t tierUpThreshold = 0;
+    unsigned compileThreads = 0;
+    JITCacheAgent* objectCache = nullptr;
+    bool perfMap = false;
+    bool debuggerSupport = false;
+    
+    bool initializeLazy();
+    bool initializeTiered();
+    bool addModuleSplit(llvm::orc::ThreadSafeModule module);
+    bool installPlugins();
     
 public:
     JITAgent();
     ~JITAgent();
     
+    // Compile on demand: modules are split into one partition per function behind
+    // lazy call-through stubs, and a partition is optimized at optLevel and
+    // compiled on its first call. Must be set before initialize()
+    void setLazy(bool enable, int optLevel);
+    bool isLazy() const { return lazy; }
+    
+    // Baseline code at O0; functions called tierUpThreshold times are recompiled
+    // at O3 in the background (see TierUpAgent). Must be set before initialize()
+    void setTiered(uint64_t threshold) { tierUpThreshold = threshold; }
+    
+    // Materialize on a pool of N threads instead of the calling thread. Eagerly
+    // compiled modules are split into N partitions so they compile concurrently.
+    // Must be set before initialize()
+    void setCompileThreads(unsigned threads) { compileThreads = threads; }
+    
+    // Consult (and fill) an on-disk object cache before compiling each module.
+    // Must be set before initialize()
+    void setObjectCache(JITCacheAgent* cache) { objectCache = cache; }
+    
+    // Profiling and debugging of JITed code (where objects are linked with JITLink):
+    // append every function to /tmp/perf-<pid>.map for perf, and register
+    // objects with GDB's JIT interface. Must be set before initialize()
+    void setPerfMap(bool enable) { perfMap = enable; }
+    void setDebuggerSupport(bool enable) { debuggerSupport = enable; }
+    
     bool initialize();
-    bool addModule(std::unique_ptr<llvm::Module> module);
+    // The module must come with the context it was built in; the JIT takes both
+    bool addModule(llvm::orc::ThreadSafeModule module);
+    // Load an object file already emitted for the module instead of compiling it again
+    bool addObjectFile(const std::string& filename);
     void* getFunctionAddress(const std::string& name);
+    // One session lookup for many symbols, so their code is compiled in parallel
+    // rather than one lookup at a time; empty on failure
+    std::vector<void*> getFunctionAddresses(const std::vector<std::string>& names);
+    
+    // Long-lived sessions: code lives in its own JITDylib and is added under a
+    // resource tracker, so it can be removed or replaced without restarting the JIT.
+    // Modules added this way are always compiled eagerly
+    llvm::orc::JITDylib* createDylib(const std::string& name);
+    bool addModule(llvm::orc::ThreadSafeModule module, llvm::orc::ResourceTrackerSP tracker);
+    bool removeModule(llvm::orc::ResourceTrackerSP tracker);
+    void* getFunctionAddress(llvm::orc::JITDylib& dylib, const std::string& name);
     
     template<typename Func>
     Func getFunction(const std::string& name) {
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "agents/CompileCacheAgent.h"
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// llvm::ObjectCache backed by the compile cache directory. Each module the JIT
+// compiles is keyed on its final IR, the target machine and the flags, so later
+// runs load the stored object instead of running codegen
+class JITCacheAgent : public llvm::ObjectCache {
+private:
+    CompileCacheAgent& cache;
+    std::vector<std::string> flags;
+    std::mutex mutex;
+    std::string target;
+    // Key computed by getObject, reused when the same module's object arrives
+    std::unordered_map<const llvm::Module*, std::string> pendingKeys;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    
+    std::string computeKey(const llvm::Module* module);
+    
+public:
+    JITCacheAgent(CompileCacheAgent& cache, std::vector<std::string> flags);
+    
+    // CPU, features and codegen level of the JIT's target machine
+    void setTarget(const std::string& description);
+    
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+    void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) override;
+    
+    uint64_t getHits() const { return hits; }
+    uint64_t getMisses() const { return misses; }
+};
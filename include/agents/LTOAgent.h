@@ -0,0 +1,39 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+enum class LTOMode {
+    None,
+    Full,
+    Thin
+};
+
+class LTOAgent {
+private:
+    int optLevel;
+    unsigned numThreads;
+    std::set<std::string> preservedSymbols;
+
+public:
+    LTOAgent(int optLevel = 2, unsigned numThreads = 0);
+
+    // Symbols that must stay visible outside the link unit (entry points, exports)
+    void preserveSymbol(const std::string& name) { preservedSymbols.insert(name); }
+
+    std::unique_ptr<llvm::Module> linkModules(std::vector<std::unique_ptr<llvm::Module>> modules);
+
+    // Full LTO: per-module pre-link pipeline, then internalize and optimize the merged module
+    void optimizePreLink(llvm::Module* module);
+    void optimizeFullLTO(llvm::Module* module);
+
+    // ThinLTO: summary-based import and parallel backends, one object per input
+    bool runThinLTO(std::vector<std::unique_ptr<llvm::Module>> modules,
+                    const std::string& outputPrefix,
+                    std::vector<std::string>& objectFiles);
+
+    static bool emitBitcodeWithSummary(llvm::Module* module, const std::string& filename);
+};
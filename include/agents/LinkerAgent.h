@@ -1,15 +1,42 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
 class LinkerAgent {
+private:
+    // C runtime pieces needed to link an ELF executable without a compiler driver
+    struct CRuntime {
+        std::string dynamicLinker;
+        std::string crtDir;
+        std::string gccDir;
+    };
+    
+    static std::optional<CRuntime> findCRuntime();
+    // lld's ELF driver in-process when built with LLD, otherwise ld.lld from PATH
+    static bool runLLD(const std::vector<std::string>& args);
+    static bool runProgram(const std::string& name, const std::vector<std::string>& args);
+    static bool linkELF(const std::vector<std::string>& objectFiles,
+                        const std::string& outputFile,
+                        const std::vector<std::string>& libraries,
+                        const std::string& symbolOrderingFile,
+                        bool shared);
+    
 public:
     static bool linkWithLLD(const std::vector<std::string>& objectFiles, 
                            const std::string& outputFile,
-                           const std::vector<std::string>& libraries = {});
+                           const std::vector<std::string>& libraries = {},
+                           const std::string& symbolOrderingFile = "");
     static bool linkWithSystemLinker(const std::vector<std::string>& objectFiles,
                                     const std::string& outputFile,
                                     const std::vector<std::string>& libraries = {});
+    // Position-independent shared library; objects must be compiled as PIC
+    static bool linkShared(const std::vector<std::string>& objectFiles,
+                           const std::string& outputFile,
+                           const std::vector<std::string>& libraries = {});
+    static bool createStaticArchive(const std::vector<std::string>& objectFiles,
+                                    const std::string& outputFile);
+    static bool linkRelocatable(const std::vector<std::string>& objectFiles,
+                                const std::string& outputFile);
 };
-
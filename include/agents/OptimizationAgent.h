@@ -14,6 +14,8 @@ private:
     
 public:
     OptimizationAgent();
+    // Builds the pipeline for the level once, without the default O2 setup first
+    explicit OptimizationAgent(int optLevel);
     
     void optimize(llvm::Module* module);
     void configureOptimizationLevel(int optLevel = 2);
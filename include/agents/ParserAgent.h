@@ -3,6 +3,8 @@
 #include "parser/Lexer.h"
 #include "parser/Parser.h"
 #include "ast/Stmt.h"
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
 #include <string>
 #include <memory>
 
@@ -16,5 +18,9 @@ public:
     std::unique_ptr<ast::Program> parse();
     
     static std::string readFile(const std::string& filename);
+    
+    // .ll and .bc inputs are loaded as LLVM modules instead of parsed as DSL
+    static bool isIRFile(const std::string& filename);
+    static std::unique_ptr<llvm::Module> loadIRFile(const std::string& filename, llvm::LLVMContext& ctx);
 };
 
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hardware performance counters around a run of JITed code, read through
+// perf_event_open (Linux only). Events are opened in groups so related counts
+// (cycles and instructions for IPC) cover exactly the same interval; counts
+// are scaled when the kernel had to multiplex a group. Only the calling thread
+// is counted, in user mode
+class PerfCounterAgent {
+private:
+    struct Counter {
+        std::string name;
+        int fd = -1;
+        uint64_t value = 0;
+    };
+    
+    struct Group {
+        std::vector<Counter> counters;
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+    
+    std::vector<Group> groups;
+    
+    const Counter* find(const std::string& name) const;
+    
+public:
+    PerfCounterAgent() = default;
+    PerfCounterAgent(const PerfCounterAgent&) = delete;
+    PerfCounterAgent& operator=(const PerfCounterAgent&) = delete;
+    ~PerfCounterAgent();
+    
+    // Opens every supported event; false if none can be counted
+    bool open();
+    
+    void start();
+    void stop();
+    
+    // Totals and per-call values, IPC and misses per thousand instructions
+    void report(const std::string& name, uint64_t calls) const;
+};
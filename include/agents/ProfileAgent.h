@@ -0,0 +1,31 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Instructions.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Counters recorded for one function: [entry, br0.true, br0.false, br1.true, ...]
+struct FunctionProfile {
+    uint64_t hash;
+    std::vector<uint64_t> counters;
+};
+
+class ProfileAgent {
+private:
+    std::unordered_map<std::string, FunctionProfile> profiles;
+
+    static uint64_t computeFunctionHash(llvm::Function& func);
+    static std::vector<llvm::BranchInst*> collectBranches(llvm::Function& func);
+
+public:
+    static constexpr const char* DumpFunctionName = "__dsl_prof_dump";
+
+    // Insert entry/edge counters and a dump routine that writes profileFile at exit
+    static bool instrument(llvm::Module* module, const std::string& profileFile);
+
+    bool readProfile(const std::string& filename);
+    bool applyProfile(llvm::Module* module);
+};
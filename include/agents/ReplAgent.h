@@ -0,0 +1,59 @@
+#pragma once
+
+#include "agents/JITAgent.h"
+#include "agents/ModuleSetupAgent.h"
+#include "ast/Stmt.h"
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Persistent JIT session: one LLJIT stays warm while files are loaded, replaced
+// and called by a stream of commands (interactive or scripted)
+class ReplAgent {
+private:
+    // A loaded input file and the code it contributed to the session
+    struct Unit {
+        std::string filename;
+        std::string source;
+        // Signatures of the functions the unit defines (bodies empty for IR inputs)
+        std::unique_ptr<ast::Program> program;
+        // Functions the unit calls but other units define
+        std::unordered_set<std::string> imports;
+        llvm::orc::ResourceTrackerSP tracker;
+    };
+    
+    JITAgent& jit;
+    int optLevel;
+    ModuleSetupAgent moduleSetup;
+    std::map<std::string, Unit> units;
+    // One JITDylib per file, kept across unload so a later load can reuse it
+    std::map<std::string, llvm::orc::JITDylib*> dylibs;
+    std::vector<std::unique_ptr<ast::Function>> stdlibPrototypes;
+    
+    bool compile(Unit& unit, llvm::orc::ThreadSafeModule& compiled);
+    bool add(Unit& unit, llvm::orc::ThreadSafeModule compiled);
+    llvm::orc::JITDylib* getDylib(const std::string& filename);
+    // Units that call any of the names, directly or through other units
+    std::vector<std::string> findDependents(const std::unordered_set<std::string>& names,
+                                            const std::string& exclude) const;
+    const Unit* findDefinition(const std::string& function, ast::Function*& func) const;
+
+public:
+    ReplAgent(JITAgent& jit, int optLevel);
+    
+    // Compile a .dsl, .ll or .bc file into its own JITDylib, replacing the
+    // previous version; units that call into it are re-added to bind to the new code
+    bool load(const std::string& filename);
+    bool unload(const std::string& filename);
+    bool call(const std::string& function, const std::vector<std::string>& args, std::string& result);
+    void list() const;
+    
+    // One command; returns false once the session should end
+    bool execute(const std::string& line);
+    void run(std::istream& input);
+};
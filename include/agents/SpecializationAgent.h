@@ -0,0 +1,49 @@
+#pragma once
+
+#include "agents/InvocationAgent.h"
+#include "agents/JITAgent.h"
+#include "ast/Stmt.h"
+#include <llvm/IR/Module.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// JIT-time partial evaluation: copies a function with some parameters fixed to
+// constants, re-optimizes the copy and adds it to the running JIT
+class SpecializationAgent {
+public:
+    // A specialized function takes only the parameters that were not fixed
+    struct Specialization {
+        std::string name;
+        void* address = nullptr;
+        EntryTrampoline entry = nullptr;
+        std::unique_ptr<ast::Function> signature;
+    };
+    
+private:
+    JITAgent& jit;
+    int optLevel;
+    // Program IR before it was handed to the JIT; copies start from here
+    std::string bitcode;
+    std::mutex mutex;
+    // Keyed on the function and its canonical constant tuple
+    std::map<std::string, std::unique_ptr<Specialization>> cache;
+    
+public:
+    SpecializationAgent(JITAgent& jit, int optLevel);
+    
+    // Must be called with the program module before the JIT takes it
+    bool setModule(const llvm::Module& module);
+    
+    // Parameters are named, or given by position ("0", "1", ...). Repeated
+    // requests for the same tuple return the cached code
+    const Specialization* specialize(const std::string& function,
+                                     const std::vector<std::pair<std::string, std::string>>& constants);
+    
+    // "fn:param=value,param=value"
+    static bool parseRequest(const std::string& text, std::string& function,
+                             std::vector<std::pair<std::string, std::string>>& constants);
+};
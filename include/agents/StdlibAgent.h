@@ -0,0 +1,21 @@
+#pragma once
+
+#include "ast/Stmt.h"
+#include <llvm/IR/Module.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// DSL standard library, embedded in the compiler as bitcode (stdlib/stdlib.ll)
+class StdlibAgent {
+public:
+    // Signatures of the library functions DSL code can call, for IR generation
+    // to declare like functions from other input files
+    static std::vector<std::unique_ptr<ast::Function>> getPrototypes();
+    
+    // Lazily load the library and link in only the functions the module calls
+    static bool linkInto(llvm::Module* module);
+    
+    // Identifies this build of the library, for cache keys
+    static std::string getContentHash();
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Two-tier JIT on top of an LLJIT that generates code at O0.
+// Every function is called through an indirect stub. The baseline tier counts
+// calls, and once a function reaches the threshold a background thread
+// recompiles it at O3 for the host CPU and repoints its stub at the new code
+class TierUpAgent {
+private:
+    struct TieredFunction {
+        std::string name;
+        size_t moduleIndex;
+        bool requested = false;
+    };
+    
+    llvm::orc::LLJIT& jit;
+    uint64_t threshold;
+    std::unique_ptr<llvm::orc::IndirectStubsManager> stubs;
+    std::unique_ptr<llvm::TargetMachine> optimizingTarget;
+    
+    // Bitcode of each module as it was before instrumentation, for the optimizing tier
+    std::vector<std::string> moduleBitcode;
+    std::vector<TieredFunction> functions;
+    
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<uint32_t> queue;
+    bool stopping = false;
+    std::thread worker;
+    
+    std::vector<std::string> instrument(llvm::Module& module);
+    void recompile(uint32_t id);
+    void workerLoop();
+    
+    // Called from baseline code: void __dsl_tier_up(ptr agent, i32 function)
+    static void tierUp(TierUpAgent* agent, uint32_t id);
+    
+public:
+    static constexpr const char* TierUpHookName = "__dsl_tier_up";
+    
+    TierUpAgent(llvm::orc::LLJIT& jit, uint64_t threshold);
+    ~TierUpAgent();
+    
+    bool initialize();
+    bool addModule(llvm::orc::ThreadSafeModule module);
+    
+    static std::string baselineName(const std::string& function);
+    static std::string optimizedName(const std::string& function);
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ast/Stmt.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ast {
+
+// Call graph over the functions defined in one Program
+class CallGraph {
+private:
+    std::unordered_map<std::string, Function*> functions;
+    std::vector<Function*> definitionOrder;
+    std::unordered_map<Function*, std::vector<std::string>> calleeNames;
+    std::unordered_map<Function*, std::vector<Function*>> edges;
+    std::unordered_map<Function*, size_t> componentIndex;
+    std::vector<std::vector<Function*>> components;
+
+    void collectCalls(Expr* expr, std::vector<std::string>& callees);
+    void computeSCCs();
+
+public:
+    explicit CallGraph(Program* program);
+
+    Function* lookup(const std::string& name) const;
+    const std::vector<std::string>& getCallees(Function* func) const;
+
+    // Strongly connected components in bottom-up order (callees before callers)
+    const std::vector<std::vector<Function*>>& getSCCs() const { return components; }
+    size_t getSCCIndex(Function* func) const { return componentIndex.at(func); }
+
+    // True if the function can reach itself through calls within the program
+    bool isRecursive(Function* func) const;
+};
+
+} // namespace ast
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+// Wall-clock time per compiler stage, reported with --time-stages.
+// Starting a stage ends the previous one; repeated stages accumulate
+class StageTimer {
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+    
+    static void begin(const std::string& stage);
+    static void end();
+    
+    // Extra detail printed next to the current (or last) stage
+    static void note(const std::string& text);
+    // Detail for a named stage, for counts only known after it has ended
+    static void note(const std::string& stage, const std::string& text);
+    
+    static void report();
+};
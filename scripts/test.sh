@@ -21,11 +21,114 @@ echo "=== Testing LLVM DSL Compiler ==="
 TEST_FILES=(
     "$PROJECT_ROOT/examples/add.dsl"
     "$PROJECT_ROOT/examples/math.dsl"
+    "$PROJECT_ROOT/examples/wrap.dsl"
+)
+
+# "file:function:args" run on the interpreter and the JIT, which must agree
+INTERP_TESTS=(
+    "$PROJECT_ROOT/examples/wrap.dsl:mix:123456,789"
+    "$PROJECT_ROOT/examples/wrap.dsl:mix:-2147483648,-1"
+    "$PROJECT_ROOT/examples/stdlib.dsl:score:-42,0,100"
+    "$PROJECT_ROOT/examples/stdlib.dsl:score:2147483647,-5,5"
+    "$PROJECT_ROOT/examples/math.dsl:divide:-7,2"
 )
 
 PASSED=0
 FAILED=0
 
+# Outputs of the feature checks below
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+LOG="$WORK_DIR/log"
+
+pass() {
+    echo "  ✓ $1"
+    PASSED=$((PASSED + 1))
+}
+
+fail() {
+    echo "  ✗ $1"
+    sed 's/^/      /' "$LOG" 2>/dev/null || true
+    FAILED=$((FAILED + 1))
+}
+
+# check <description> <compiler args...>: the run must succeed
+check() {
+    local name="$1"
+    shift
+    if "$COMPILER" "$@" > "$LOG" 2>&1; then
+        pass "$name"
+    else
+        fail "$name"
+    fi
+}
+
+# check_log <description> <pattern> <compiler args...>: the run must succeed
+# and its output match the pattern
+check_log() {
+    local name="$1" pattern="$2"
+    shift 2
+    if "$COMPILER" "$@" > "$LOG" 2>&1 && grep -q -e "$pattern" "$LOG"; then
+        pass "$name"
+    else
+        fail "$name"
+    fi
+}
+
+# check_error <description> <pattern> <compiler args...>: the run must fail
+# and its output match the pattern
+check_error() {
+    local name="$1" pattern="$2"
+    shift 2
+    if ! "$COMPILER" "$@" > "$LOG" 2>&1 && grep -q -e "$pattern" "$LOG"; then
+        pass "$name"
+    else
+        fail "$name"
+    fi
+}
+
+# check_exit <description> <status> <executable>: a linked program must exit
+# with the status main() returned (modulo 256)
+check_exit() {
+    local status=0
+    "$3" > "$LOG" 2>&1 || status=$?
+    if [ "$status" -eq "$2" ]; then
+        pass "$1"
+    else
+        fail "$1: exit status $status, expected $2"
+    fi
+}
+
+# Value a run printed: the --entry result, or what main() returned
+run_value() {
+    "$COMPILER" "$@" 2>&1 | awk '
+        /^\[INFO\] Program returned: / { value = $NF; next }
+        /^\[/ || /^===/ || /^$/ { next }
+        { value = $0 }
+        END { print value }'
+}
+
+# check_value <description> <expected> <compiler args...>
+check_value() {
+    local name="$1" expected="$2" value
+    shift 2
+    value=$(run_value "$@")
+    if [ "$value" = "$expected" ]; then
+        pass "$name"
+    else
+        fail "$name: expected $expected, got '$value'"
+    fi
+}
+
+# check_file <description> <file>: an earlier check must have written the file
+check_file() {
+    if [ -s "$2" ]; then
+        pass "$1"
+    else
+        fail "$1"
+    fi
+}
+
 for test_file in "${TEST_FILES[@]}"; do
     if [ ! -f "$test_file" ]; then
         echo "Warning: Test file not found: $test_file"
@@ -46,20 +149,320 @@ for test_file in "${TEST_FILES[@]}"; do
             # Try JIT execution
             if "$COMPILER" "$test_file" --jit 2>&1; then
                 echo "  ✓ JIT execution passed"
-                ((PASSED++))
+                PASSED=$((PASSED + 1))
             else
                 echo "  ✗ JIT execution failed"
-                ((FAILED++))
+                FAILED=$((FAILED + 1))
             fi
         else
             echo "  ✗ IR file not created"
-            ((FAILED++))
+            FAILED=$((FAILED + 1))
         fi
     else
         echo "  ✗ Compilation failed"
-        ((FAILED++))
+        FAILED=$((FAILED + 1))
+    fi
+done
+
+echo ""
+echo "Testing: profile-guided optimization"
+check "Instrumented JIT run" "$PROJECT_ROOT/examples/add.dsl" --jit --profile-generate \
+    --profile-output="$WORK_DIR/add.dslprof"
+check_file "Profile written" "$WORK_DIR/add.dslprof"
+check_log "Profile applied to the next build" "Profile applied to" "$PROJECT_ROOT/examples/add.dsl" \
+    --profile-use="$WORK_DIR/add.dslprof" -o "$WORK_DIR/add_pgo.o"
+
+echo ""
+echo "Testing: hot/cold splitting"
+check_file "Profiled build ordered its hot functions" "$WORK_DIR/add_pgo.o.order"
+check_log "Splitting without a profile warns" "needs --profile-use" "$PROJECT_ROOT/examples/add.dsl" \
+    --hot-cold-split -o "$WORK_DIR/add_split.o"
+
+# shapes.dsl calls functions defined in shapes_lib.dsl; main() returns 61
+SHAPES=("$PROJECT_ROOT/examples/shapes.dsl" "$PROJECT_ROOT/examples/shapes_lib.dsl")
+
+echo ""
+echo "Testing: multiple inputs and LTO"
+check_value "Multi-file JIT run" 61 "${SHAPES[@]}" --jit
+check_value "Multi-file JIT run with --lto=full" 61 "${SHAPES[@]}" --lto=full --jit
+check_log "ThinLTO emits an object per input" "ThinLTO produced 2 object" "${SHAPES[@]}" \
+    --lto=thin -o "$WORK_DIR/shapes"
+check_file "ThinLTO object written" "$WORK_DIR/shapes.thinlto.1.o"
+
+echo ""
+echo "Testing: parallel IR generation"
+check_value "math.dsl lowered on 4 threads" 520 "$PROJECT_ROOT/examples/math.dsl" --irgen-threads=4 --jit
+check_value "Multi-file program lowered on 2 threads" 61 "${SHAPES[@]}" --irgen-threads=2 --jit
+
+echo ""
+echo "Testing: IR generation errors"
+cat > "$WORK_DIR/arity.dsl" <<'EOF'
+fn add(a: i32, b: i32) -> i32 {
+    return a + b;
+}
+
+fn main() -> i32 {
+    return add(1);
+}
+EOF
+cat > "$WORK_DIR/unknown.dsl" <<'EOF'
+fn main() -> i32 {
+    let x: i32 = 1;
+    return x + missing;
+}
+EOF
+check_error "Wrong argument count is an error" "Argument count mismatch" "$WORK_DIR/arity.dsl" --emit-ir \
+    -o "$WORK_DIR/arity.ll"
+check_error "Unknown variable is an error" "Unknown variable" "$WORK_DIR/unknown.dsl" --emit-ir \
+    -o "$WORK_DIR/unknown.ll"
+check_error "Parallel IR generation reports the same error" "Argument count mismatch" "$WORK_DIR/arity.dsl" \
+    --irgen-threads=2 --emit-ir -o "$WORK_DIR/arity.ll"
+
+echo ""
+echo "Testing: parallel code generation"
+check_log "Object emitted on 4 threads" "Emitted [0-9]* object file" "$PROJECT_ROOT/examples/math.dsl" \
+    -j4 -o "$WORK_DIR/math_j.o"
+check_file "Partitions merged into one object" "$WORK_DIR/math_j.o"
+if ls "$WORK_DIR"/math_j.part*.o > /dev/null 2>&1; then
+    fail "Partition objects removed after merging"
+else
+    pass "Partition objects removed after merging"
+fi
+
+echo ""
+echo "Testing: several outputs from one compile"
+check "IR, assembly and object in one run" "$PROJECT_ROOT/examples/math.dsl" --emit-ir --emit-asm --emit-obj \
+    -o "$WORK_DIR/multi.o"
+check_file "IR written" "$WORK_DIR/multi.ll"
+check_file "Assembly written" "$WORK_DIR/multi.s"
+check_file "Object written" "$WORK_DIR/multi.o"
+check "Assembly next to a parallel object" "$PROJECT_ROOT/examples/math.dsl" --emit-asm --emit-obj -j2 \
+    -o "$WORK_DIR/multi_j.o"
+check_file "Assembly written with -j" "$WORK_DIR/multi_j.s"
+
+echo ""
+echo "Testing: compile cache"
+CACHE_DIR="$WORK_DIR/cache"
+check_log "First build misses" "Cache miss" "$PROJECT_ROOT/examples/add.dsl" --cache-dir="$CACHE_DIR" \
+    -o "$WORK_DIR/cached.o"
+check_log "Second build hits" "Cache hit" "$PROJECT_ROOT/examples/add.dsl" --cache-dir="$CACHE_DIR" \
+    -o "$WORK_DIR/cached.o"
+cp "$WORK_DIR/cached.o" "$WORK_DIR/cached_add.o"
+# A different program written to the same output must not change the entry
+check_log "Other program misses" "Cache miss" "$PROJECT_ROOT/examples/math.dsl" --cache-dir="$CACHE_DIR" \
+    -o "$WORK_DIR/cached.o"
+check_log "Third build hits again" "Cache hit" "$PROJECT_ROOT/examples/add.dsl" --cache-dir="$CACHE_DIR" \
+    -o "$WORK_DIR/cached.o"
+if cmp -s "$WORK_DIR/cached.o" "$WORK_DIR/cached_add.o"; then
+    pass "Cached object unchanged by the other build"
+else
+    fail "Cached object unchanged by the other build"
+fi
+
+echo ""
+echo "Testing: incremental builds"
+cp "$PROJECT_ROOT/examples/math.dsl" "$WORK_DIR/inc.dsl"
+check_log "First build reuses nothing" "Reusing 0 of" "$WORK_DIR/inc.dsl" --incremental \
+    --cache-dir="$WORK_DIR/inc_cache" -o "$WORK_DIR/inc.o"
+# Only main() changes: 100 * 4 + 100 / 4
+sed -i.orig 's/let y: i32 = 5;/let y: i32 = 4;/' "$WORK_DIR/inc.dsl"
+check_log "Edited build reuses unchanged functions" "Reusing [1-9][0-9]* of" "$WORK_DIR/inc.dsl" --incremental \
+    --cache-dir="$WORK_DIR/inc_cache" -o "$WORK_DIR/inc.o"
+check_value "Reused functions run correctly" 425 "$WORK_DIR/inc.dsl" --incremental \
+    --cache-dir="$WORK_DIR/inc_cache" --jit
+
+echo ""
+echo "Testing: linking"
+# main() returns 520, so the executables exit with 520 % 256
+check_log "Executable linked" "Linking completed successfully" "$PROJECT_ROOT/examples/math.dsl" --link \
+    -o "$WORK_DIR/linked.o"
+check_exit "Linked executable runs" 8 "$WORK_DIR/linked.out"
+check_log "Executable linked from parallel partitions" "Linking completed successfully" \
+    "$PROJECT_ROOT/examples/math.dsl" -j2 --link -o "$WORK_DIR/linked_j.o"
+check_exit "Executable from partitions runs" 8 "$WORK_DIR/linked_j.out"
+
+echo ""
+echo "Testing: libraries"
+check "Shared library built" "$PROJECT_ROOT/examples/math.dsl" --emit-shared -o "$WORK_DIR/libmath.so"
+check_file "Shared library written" "$WORK_DIR/libmath.so"
+if grep -q "int32_t multiply(int32_t" "$WORK_DIR/libmath.h" 2>/dev/null; then
+    pass "Header declares the library's functions"
+else
+    fail "Header declares the library's functions"
+fi
+if command -v cc > /dev/null 2>&1; then
+    cat > "$WORK_DIR/host.c" <<'EOF'
+#include "libmath.h"
+
+int main(void) {
+    return multiply(6, 7) == 42 && divide(84, 2) == 42 ? 0 : 1;
+}
+EOF
+    if cc -I"$WORK_DIR" "$WORK_DIR/host.c" "$WORK_DIR/libmath.so" -o "$WORK_DIR/host" > "$LOG" 2>&1; then
+        check_exit "C host calls into the shared library" 0 "$WORK_DIR/host"
+    else
+        fail "C host compiles against the header"
+    fi
+fi
+check "Static library built" "$PROJECT_ROOT/examples/math.dsl" --emit-static -o "$WORK_DIR/libmath_static.a"
+check_file "Static archive written" "$WORK_DIR/libmath_static.a"
+# Full LTO must not internalize what the library exports
+check "Shared library built with --lto=full" "${SHAPES[@]}" --lto=full --emit-shared -o "$WORK_DIR/libshapes.so"
+if grep -q "int32_t rect_area(int32_t" "$WORK_DIR/libshapes.h" 2>/dev/null; then
+    pass "Full LTO keeps the library's exports"
+else
+    fail "Full LTO keeps the library's exports"
+fi
+
+echo ""
+echo "Testing: standard library"
+check_value "Standard library calls" 100 "$PROJECT_ROOT/examples/stdlib.dsl" --jit
+cat > "$WORK_DIR/override.dsl" <<'EOF'
+fn max_i32(a: i32, b: i32) -> i32 {
+    return a - b;
+}
+
+fn main() -> i32 {
+    return max_i32(1, 5);
+}
+EOF
+check_value "A program's own definition replaces the library's" -4 "$WORK_DIR/override.dsl" --jit
+
+echo ""
+echo "Testing: REPL session"
+REPL_OUT="$WORK_DIR/repl.out"
+printf 'fn f() -> i32 {\n    return 1;\n}\n' > "$WORK_DIR/repl_f.dsl"
+printf 'fn g() -> i32 {\n    return f() + 10;\n}\n' > "$WORK_DIR/repl_g.dsl"
+# Waits until the session has printed $1 results, so the file can be edited
+# between commands
+repl_wait() {
+    for _ in $(seq 100); do
+        if [ "$(grep -c -v -e '^\[' -e '^$' "$REPL_OUT" 2>/dev/null)" -ge "$1" ]; then
+            return
+        fi
+        sleep 0.1
+    done
+}
+{
+    echo "load $WORK_DIR/repl_f.dsl $WORK_DIR/repl_g.dsl"
+    echo "call g"
+    repl_wait 1
+    printf 'fn f() -> i32 {\n    return 2;\n}\n' > "$WORK_DIR/repl_f.dsl"
+    echo "reload $WORK_DIR/repl_f.dsl"
+    echo "call g"
+    repl_wait 2
+    # A version that does not compile leaves the previous one running
+    printf 'fn f() -> i32 {\n    return ;\n' > "$WORK_DIR/repl_f.dsl"
+    echo "reload $WORK_DIR/repl_f.dsl"
+    echo "call g"
+    echo "quit"
+} | "$COMPILER" --repl > "$REPL_OUT" 2>&1 || true
+results=$(grep -v -e '^\[' -e '^$' "$REPL_OUT" | tr '\n' ' ')
+cp "$REPL_OUT" "$LOG"
+if [ "$results" = "11 12 12 " ]; then
+    pass "Reloading rebinds callers and a failed reload keeps the old code"
+else
+    fail "Reloading rebinds callers and a failed reload keeps the old code: got '$results'"
+fi
+
+echo ""
+echo "Testing: JIT runs that write output"
+check_value "JIT run loads the object it writes" 520 "$PROJECT_ROOT/examples/math.dsl" --jit -o "$WORK_DIR/jit.o"
+check_file "Object written by a JIT run" "$WORK_DIR/jit.o"
+check_value "JIT run with assembly output" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --emit-asm -o "$WORK_DIR/jit.s"
+check_value "JIT run with IR output" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --emit-ir -o "$WORK_DIR/jit.ll"
+check_file "IR written by a JIT run" "$WORK_DIR/jit.ll"
+
+echo ""
+echo "Testing: lazy JIT"
+check_value "Functions compiled on first call" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --jit-lazy
+check_value "Lazy JIT across input files" 61 "${SHAPES[@]}" --jit --jit-lazy
+
+echo ""
+echo "Testing: tiered JIT"
+# Recompiles run in the background and may not finish before exit, so only
+# the results are checked
+check_value "Tiered JIT result" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --jit-tiered --tier-up-threshold=1
+check "Tiered JIT with profile counters" "$PROJECT_ROOT/examples/add.dsl" --jit --jit-tiered \
+    --tier-up-threshold=1 --profile-generate --profile-output="$WORK_DIR/tiered.dslprof"
+check_file "Profile written by the tiered JIT" "$WORK_DIR/tiered.dslprof"
+
+echo ""
+echo "Testing: concurrent JIT compilation"
+check_value "math.dsl compiled on 4 JIT threads" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --jit-threads=4
+check_value "Lazy JIT on 2 threads" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --jit-lazy --jit-threads=2
+
+echo ""
+echo "Testing: JIT object cache"
+rm -rf "$WORK_DIR/jit_cache"
+check_value "JIT run filling the cache" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --cache-dir="$WORK_DIR/jit_cache"
+check_log "JIT run loading from the cache" "Loaded cached object" "$PROJECT_ROOT/examples/math.dsl" \
+    --jit --cache-dir="$WORK_DIR/jit_cache"
+check_value "Cached JIT result" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --cache-dir="$WORK_DIR/jit_cache"
+
+echo ""
+echo "Testing: JIT profiling and debugging"
+check_log "Perf map for JITed code" "Writing perf map" "$PROJECT_ROOT/examples/math.dsl" --jit --jit-perf-map
+check_value "JIT run registered with GDB" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --jit-debug
+
+echo ""
+echo "Testing: entry points and batches"
+check_value "--entry with --args" 5 "$PROJECT_ROOT/examples/add.dsl" --jit --entry=add --args=2,3
+printf '1,2\n# comment\n10,20\n-4,4\n' > "$WORK_DIR/batch.csv"
+for threads in 1 2; do
+    rm -f "$WORK_DIR/batch.out"
+    check "Batch of CSV tuples on $threads thread(s)" "$PROJECT_ROOT/examples/add.dsl" --jit --entry=add \
+        --batch="$WORK_DIR/batch.csv" --batch-output="$WORK_DIR/batch.out" --batch-threads=$threads
+    if [ "$(tr '\n' ' ' < "$WORK_DIR/batch.out" 2>/dev/null)" = "3 30 0 " ]; then
+        pass "Batch results in input order on $threads thread(s)"
+    else
+        fail "Batch results in input order on $threads thread(s)"
+    fi
+done
+
+echo ""
+echo "Testing: benchmarking"
+check_log "Timed JIT calls of main()" "^median " "$PROJECT_ROOT/examples/math.dsl" --jit --bench=50 --bench-warmup=5
+check_log "Timed calls of --entry" "Benchmark: add" "$PROJECT_ROOT/examples/add.dsl" --jit --entry=add --args=2,3 \
+    --bench=50 --bench-warmup=5
+check "Benchmark written as JSON" "$PROJECT_ROOT/examples/math.dsl" --jit --bench=50 --bench-warmup=5 \
+    --bench-json="$WORK_DIR/bench.json"
+if grep -q '"median": ' "$WORK_DIR/bench.json" 2>/dev/null; then
+    pass "Benchmark JSON has the statistics"
+else
+    fail "Benchmark JSON has the statistics"
+fi
+
+echo ""
+echo "Testing: hardware counters"
+# Containers and VMs often expose no counters; the run must still succeed
+check_value "JIT run under --perf-stat" 520 "$PROJECT_ROOT/examples/math.dsl" --jit --perf-stat
+check_log "Counters or a warning for --entry" "Performance Counters: add\|no hardware counters" \
+    "$PROJECT_ROOT/examples/add.dsl" --jit --perf-stat --entry=add --args=2,3
+
+echo ""
+echo "Testing: runtime specialization"
+check_value "Specialized --entry" 12 "$PROJECT_ROOT/examples/add.dsl" --jit --entry=add --specialize add:b=10 --args=2
+check_value "Specialized --entry after full LTO" 12 "$PROJECT_ROOT/examples/add.dsl" --lto=full --jit \
+    --entry=add --specialize add:b=10 --args=2
+check_log "Specialized function kept by full LTO" "Specialization Agent" "$PROJECT_ROOT/examples/add.dsl" \
+    --lto=full --jit --specialize add:1=10
+check_error "Unknown parameter rejected" "Failed to specialize" "$PROJECT_ROOT/examples/add.dsl" --jit \
+    --specialize add:c=1
+
+for test_case in "${INTERP_TESTS[@]}"; do
+    IFS=':' read -r file function args <<< "$test_case"
+    echo ""
+    echo "Testing: --interp against --jit for $function($args)"
+    interpreted=$(run_value "$file" --interp --entry="$function" --args="$args")
+    compiled=$(run_value "$file" --jit --entry="$function" --args="$args")
+    if [ -n "$interpreted" ] && [ "$interpreted" = "$compiled" ]; then
+        pass "Both returned $interpreted"
+    else
+        fail "Interpreter returned '$interpreted', JIT returned '$compiled'"
     fi
 done
+check_value "--interp=auto runs main()" 520 "$PROJECT_ROOT/examples/math.dsl" --interp=auto
 
 echo ""
 echo "=== Test Results ==="
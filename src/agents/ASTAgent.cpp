@@ -3,6 +3,57 @@
 #include <iostream>
 #include <stdexcept>
 
+namespace {
+
+void fingerprintExpr(ast::Expr* expr, std::string& out) {
+    if (!expr) {
+        out += "_";
+        return;
+    }
+    
+    switch (expr->type) {
+        case ast::ASTNodeType::BinaryExpr: {
+            auto* binary = static_cast<ast::BinaryExpr*>(expr);
+            out += "(b" + std::to_string(static_cast<int>(binary->op)) + " ";
+            fingerprintExpr(binary->left.get(), out);
+            out += " ";
+            fingerprintExpr(binary->right.get(), out);
+            out += ")";
+            break;
+        }
+        case ast::ASTNodeType::UnaryExpr: {
+            auto* unary = static_cast<ast::UnaryExpr*>(expr);
+            out += "(u" + std::to_string(static_cast<int>(unary->op)) + " ";
+            fingerprintExpr(unary->operand.get(), out);
+            out += ")";
+            break;
+        }
+        case ast::ASTNodeType::Literal: {
+            auto* literal = static_cast<ast::LiteralExpr*>(expr);
+            out += "(l" + std::to_string(literal->type.kind) + " " + literal->value + ")";
+            break;
+        }
+        case ast::ASTNodeType::Variable:
+            out += "(v " + static_cast<ast::VariableExpr*>(expr)->name + ")";
+            break;
+        case ast::ASTNodeType::Call: {
+            auto* call = static_cast<ast::CallExpr*>(expr);
+            out += "(c " + call->callee;
+            for (const auto& arg : call->args) {
+                out += " ";
+                fingerprintExpr(arg.get(), out);
+            }
+            out += ")";
+            break;
+        }
+        default:
+            out += "(?)";
+            break;
+    }
+}
+
+} // namespace
+
 void ASTAgent::validateAST(ast::Program* program) {
     LOG_INFO("ASTAgent: Validating AST");
     
@@ -27,3 +78,32 @@ void ASTAgent::dumpAST(ast::Program* program, int indent) {
     }
 }
 
+
+std::string ASTAgent::fingerprint(ast::Function* func) {
+    std::string out = "fn " + func->name + " " + std::to_string(func->returnType.kind) + " (";
+    for (const auto& param : func->params) {
+        out += param.first + ":" + std::to_string(param.second.kind) + " ";
+    }
+    out += ")";
+    
+    for (const auto& stmt : func->body) {
+        switch (stmt->type) {
+            case ast::ASTNodeType::Return:
+                out += " (ret ";
+                fingerprintExpr(static_cast<ast::ReturnStmt*>(stmt.get())->expr.get(), out);
+                out += ")";
+                break;
+            case ast::ASTNodeType::Let: {
+                auto* let = static_cast<ast::LetStmt*>(stmt.get());
+                out += " (let " + let->name + ":" + std::to_string(let->type.kind) + " ";
+                fingerprintExpr(let->value.get(), out);
+                out += ")";
+                break;
+            }
+            default:
+                out += " (?)";
+                break;
+        }
+    }
+    return out;
+}
@@ -0,0 +1,162 @@
+#include "agents/BatchAgent.h"
+#include "utils/Logger.h"
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+bool isBinaryFile(const std::string& filename) {
+    return llvm::sys::path::extension(filename) == ".bin";
+}
+
+} // namespace
+
+BatchAgent::BatchAgent(EntryTrampoline entry, const ast::Function& signature)
+    : entry(entry), name(signature.name), returnType(signature.returnType) {
+    for (const auto& param : signature.params) {
+        paramTypes.push_back(param.second);
+    }
+}
+
+bool BatchAgent::parseTuple(const std::vector<std::string>& fields, InvocationSlot* slots,
+                            const std::string& where) const {
+    if (fields.size() != paramTypes.size()) {
+        LOG_ERROR("BatchAgent: " + where + name + " expects " + std::to_string(paramTypes.size()) +
+                  " argument(s), got " + std::to_string(fields.size()));
+        return false;
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (!InvocationAgent::parseValue(fields[i], paramTypes[i], slots[i])) {
+            LOG_ERROR("BatchAgent: " + where + "Invalid value for argument " + std::to_string(i + 1) +
+                      ": " + fields[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BatchAgent::parseArguments(const std::vector<std::string>& args, std::vector<InvocationSlot>& slots) const {
+    slots.assign(args.size(), InvocationSlot{});
+    return parseTuple(args, slots.data(), "");
+}
+
+bool BatchAgent::readInputs(const std::string& filename, std::vector<InvocationSlot>& inputs) const {
+    if (paramTypes.empty()) {
+        LOG_ERROR("BatchAgent: " + name + " takes no arguments");
+        return false;
+    }
+    
+    auto buffer = llvm::MemoryBuffer::getFile(filename);
+    if (!buffer) {
+        LOG_ERROR("BatchAgent: Cannot read " + filename + ": " + buffer.getError().message());
+        return false;
+    }
+    llvm::StringRef data = (*buffer)->getBuffer();
+    
+    if (isBinaryFile(filename)) {
+        size_t rowSize = paramTypes.size() * sizeof(InvocationSlot);
+        if (data.size() % rowSize != 0) {
+            LOG_ERROR("BatchAgent: " + filename + " is not a whole number of " +
+                      std::to_string(rowSize) + "-byte tuples");
+            return false;
+        }
+        inputs.resize(data.size() / sizeof(InvocationSlot));
+        std::memcpy(inputs.data(), data.data(), data.size());
+        return true;
+    }
+    
+    inputs.clear();
+    size_t lineNumber = 0;
+    while (!data.empty()) {
+        llvm::StringRef line;
+        std::tie(line, data) = data.split('\n');
+        lineNumber++;
+        line = line.trim();
+        if (line.empty() || line.starts_with("#")) continue;
+    
+        llvm::SmallVector<llvm::StringRef, 8> parts;
+        line.split(parts, ',');
+        std::vector<std::string> fields;
+        for (llvm::StringRef part : parts) {
+            fields.push_back(part.trim().str());
+        }
+    
+        size_t row = inputs.size();
+        inputs.resize(row + paramTypes.size());
+        if (!parseTuple(fields, &inputs[row], filename + ":" + std::to_string(lineNumber) + ": ")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BatchAgent::run(const std::vector<InvocationSlot>& inputs, std::vector<InvocationSlot>& results,
+                     unsigned threads) const {
+    size_t arity = paramTypes.size();
+    size_t rows = inputs.size() / arity;
+    results.assign(rows, InvocationSlot{});
+    
+    auto runRows = [&](size_t begin, size_t end) {
+        for (size_t row = begin; row < end; row++) {
+            entry(&inputs[row * arity], &results[row]);
+        }
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    size_t workers = std::max<size_t>(1, std::min<size_t>(threads, rows));
+    if (workers == 1) {
+        runRows(0, rows);
+    } else {
+        std::vector<std::thread> pool;
+        size_t chunk = (rows + workers - 1) / workers;
+        for (size_t begin = 0; begin < rows; begin += chunk) {
+            pool.emplace_back(runRows, begin, std::min(rows, begin + chunk));
+        }
+        for (auto& worker : pool) {
+            worker.join();
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::string rate = seconds > 0 ? ", " + std::to_string(static_cast<uint64_t>(rows / seconds)) + " calls/s" : "";
+    LOG_INFO("BatchAgent: " + std::to_string(rows) + " call(s) to " + name + " on " + std::to_string(workers) +
+             " thread(s) in " + std::to_string(seconds * 1000) + " ms" + rate);
+}
+
+bool BatchAgent::writeResults(const std::string& filename, const std::vector<InvocationSlot>& results) const {
+    if (returnType.kind == ast::Type::Void) {
+        return true;
+    }
+    
+    std::unique_ptr<llvm::raw_fd_ostream> file;
+    if (!filename.empty()) {
+        std::error_code EC;
+        file = std::make_unique<llvm::raw_fd_ostream>(filename, EC);
+        if (EC) {
+            LOG_ERROR("BatchAgent: Cannot write " + filename + ": " + EC.message());
+            return false;
+        }
+    }
+    
+    if (file && isBinaryFile(filename)) {
+        file->write(reinterpret_cast<const char*>(results.data()), results.size() * sizeof(InvocationSlot));
+    } else {
+        llvm::raw_ostream& out = file ? static_cast<llvm::raw_ostream&>(*file) : llvm::outs();
+        for (const auto& result : results) {
+            out << InvocationAgent::formatValue(result, returnType) << "\n";
+        }
+        out.flush();
+    }
+    
+    if (file) {
+        LOG_INFO("BatchAgent: Wrote " + std::to_string(results.size()) + " result(s) to " + filename);
+    }
+    return true;
+}
@@ -0,0 +1,247 @@
+#include "agents/BenchmarkAgent.h"
+#include "utils/Logger.h"
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+// Keeps the calling thread on one CPU for its lifetime, then restores the
+// previous affinity
+class CPUPin {
+#ifdef __linux__
+private:
+    cpu_set_t previous;
+    bool pinned = false;
+    
+public:
+    CPUPin() {
+        int cpu = sched_getcpu();
+        if (cpu < 0 || sched_getaffinity(0, sizeof(previous), &previous) != 0) return;
+        cpu_set_t single;
+        CPU_ZERO(&single);
+        CPU_SET(cpu, &single);
+        pinned = sched_setaffinity(0, sizeof(single), &single) == 0;
+        if (pinned) {
+            LOG_INFO("BenchmarkAgent: Pinned to CPU " + std::to_string(cpu));
+        }
+    }
+    
+    ~CPUPin() {
+        if (pinned) {
+            sched_setaffinity(0, sizeof(previous), &previous);
+        }
+    }
+#endif
+};
+
+// Reads the invariant TSC when the CPU has one (cheaper and finer than the OS
+// clock), otherwise steady_clock; both are converted to nanoseconds
+class Clock {
+private:
+    bool useTSC = false;
+    double nanosPerTick = 1.0;
+    
+public:
+    Clock() {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax, ebx, ecx, edx;
+        if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8))) {
+            // Calibrate against steady_clock over a short busy wait
+            auto wallStart = std::chrono::steady_clock::now();
+            uint64_t tscStart = __rdtsc();
+            while (std::chrono::steady_clock::now() - wallStart < std::chrono::milliseconds(20)) {
+            }
+            uint64_t ticks = __rdtsc() - tscStart;
+            double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wallStart).count();
+            if (ticks > 0) {
+                useTSC = true;
+                nanosPerTick = nanos / ticks;
+            }
+        }
+#endif
+    }
+    
+    const char* name() const { return useTSC ? "tsc" : "steady_clock"; }
+    
+    uint64_t now() const {
+#if defined(__x86_64__) || defined(__i386__)
+        if (useTSC) {
+            // Fences keep the timed call from being reordered around the reads
+            _mm_lfence();
+            uint64_t ticks = __rdtsc();
+            _mm_lfence();
+            return ticks;
+        }
+#endif
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+    
+    double toNanos(uint64_t ticks) const {
+        if (useTSC) {
+            return ticks * nanosPerTick;
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::duration(ticks)).count();
+    }
+};
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t index = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::min(sorted.size(), std::max<size_t>(index, 1)) - 1];
+}
+
+} // namespace
+
+BenchmarkAgent::BenchmarkAgent(unsigned iterations, unsigned warmup)
+    : iterations(std::max(1u, iterations)), warmup(warmup) {}
+
+void BenchmarkAgent::summarize(BenchmarkResult& result) {
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    
+    result.min = sorted.front();
+    result.median = percentile(sorted, 0.5);
+    result.p90 = percentile(sorted, 0.9);
+    result.p99 = percentile(sorted, 0.99);
+    
+    double sum = 0;
+    for (double sample : sorted) {
+        sum += sample;
+    }
+    result.mean = sum / sorted.size();
+    
+    double squares = 0;
+    for (double sample : sorted) {
+        squares += (sample - result.mean) * (sample - result.mean);
+    }
+    result.stddev = sorted.size() > 1 ? std::sqrt(squares / (sorted.size() - 1)) : 0;
+}
+
+BenchmarkResult BenchmarkAgent::measure(const std::string& name, llvm::function_ref<void()> call) const {
+    CPUPin pin;
+    Clock clock;
+    
+    BenchmarkResult result;
+    result.name = name;
+    result.clock = clock.name();
+    result.warmup = warmup;
+    
+    for (unsigned i = 0; i < warmup; i++) {
+        call();
+    }
+    
+    // Cost of reading the clock twice, taken as the minimum over many empty samples
+    uint64_t overhead = UINT64_MAX;
+    for (unsigned i = 0; i < 1000; i++) {
+        uint64_t start = clock.now();
+        uint64_t end = clock.now();
+        overhead = std::min(overhead, end - start);
+    }
+    
+    std::vector<uint64_t> ticks(iterations);
+    if (counters) counters->start();
+    for (unsigned i = 0; i < iterations; i++) {
+        uint64_t start = clock.now();
+        call();
+        uint64_t end = clock.now();
+        ticks[i] = end - start;
+    }
+    if (counters) counters->stop();
+    
+    result.samples.reserve(iterations);
+    for (uint64_t sample : ticks) {
+        result.samples.push_back(clock.toNanos(sample > overhead ? sample - overhead : 0));
+    }
+    summarize(result);
+    return result;
+}
+
+bool BenchmarkAgent::measureExecutable(const std::string& path, BenchmarkResult& result) const {
+    CPUPin pin;
+    
+    result = BenchmarkResult();
+    result.name = path;
+    result.clock = "steady_clock";
+    result.warmup = warmup;
+    
+    llvm::StringRef argv[] = {path};
+    auto runOnce = [&](double* nanos) {
+        std::string errorMessage;
+        auto start = std::chrono::steady_clock::now();
+        int status = llvm::sys::ExecuteAndWait(path, argv, std::nullopt, {}, 0, 0, &errorMessage);
+        auto end = std::chrono::steady_clock::now();
+        // Exit codes are the program's own result; only failing to run or crashing is an error
+        if (status < 0) {
+            LOG_ERROR("BenchmarkAgent: Cannot run " + path + ": " + errorMessage);
+            return false;
+        }
+        if (nanos) {
+            *nanos = std::chrono::duration<double, std::nano>(end - start).count();
+        }
+        return true;
+    };
+    
+    for (unsigned i = 0; i < warmup; i++) {
+        if (!runOnce(nullptr)) return false;
+    }
+    result.samples.resize(iterations);
+    for (unsigned i = 0; i < iterations; i++) {
+        if (!runOnce(&result.samples[i])) return false;
+    }
+    summarize(result);
+    return true;
+}
+
+void BenchmarkAgent::printText(const BenchmarkResult& result) {
+    std::cout << "\n=== Benchmark: " << result.name << " ===" << std::endl;
+    std::cout << result.samples.size() << " iterations after " << result.warmup << " warmup, clock "
+              << result.clock << std::endl;
+    auto precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "min     " << std::setw(14) << result.min << " ns" << std::endl;
+    std::cout << "median  " << std::setw(14) << result.median << " ns" << std::endl;
+    std::cout << "p90     " << std::setw(14) << result.p90 << " ns" << std::endl;
+    std::cout << "p99     " << std::setw(14) << result.p99 << " ns" << std::endl;
+    std::cout << "mean    " << std::setw(14) << result.mean << " ns" << std::endl;
+    std::cout << "stddev  " << std::setw(14) << result.stddev << " ns" << std::endl;
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout.precision(precision);
+}
+
+bool BenchmarkAgent::writeJSON(const BenchmarkResult& result, const std::string& filename) {
+    std::error_code EC;
+    llvm::raw_fd_ostream out(filename, EC);
+    if (EC) {
+        LOG_ERROR("BenchmarkAgent: Cannot write " + filename + ": " + EC.message());
+        return false;
+    }
+    
+    out << "{\n";
+    out << "  \"name\": \"";
+    out.write_escaped(result.name);
+    out << "\",\n";
+    out << "  \"clock\": \"" << result.clock << "\",\n";
+    out << "  \"unit\": \"ns\",\n";
+    out << "  \"iterations\": " << result.samples.size() << ",\n";
+    out << "  \"warmup\": " << result.warmup << ",\n";
+    out << "  \"min\": " << llvm::format("%.3f", result.min) << ",\n";
+    out << "  \"median\": " << llvm::format("%.3f", result.median) << ",\n";
+    out << "  \"p90\": " << llvm::format("%.3f", result.p90) << ",\n";
+    out << "  \"p99\": " << llvm::format("%.3f", result.p99) << ",\n";
+    out << "  \"mean\": " << llvm::format("%.3f", result.mean) << ",\n";
+    out << "  \"stddev\": " << llvm::format("%.3f", result.stddev) << "\n";
+    out << "}\n";
+    return true;
+}
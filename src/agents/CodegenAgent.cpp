@@ -6,7 +6,15 @@
 #include <llvm/TargetParser/Host.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/CodeGen/Passes.h>
+#include <llvm/Bitcode/BitcodeReader.h>
 #include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <optional>
 #include <fstream>
 
@@ -18,33 +26,105 @@ CodegenAgent::CodegenAgent() {
     llvm::InitializeNativeTargetAsmPrinter();
 }
 
-bool CodegenAgent::initializeTarget() {
+std::unique_ptr<llvm::TargetMachine> CodegenAgent::createTargetMachine() const {
     std::string error;
     auto target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
     if (!target) {
         LOG_ERROR("CodegenAgent: Cannot find target: " + error);
-        return false;
+        return nullptr;
     }
     
     llvm::TargetOptions opt;
+    if (hotColdSplitting) {
+        // Hot/cold section prefixes are assigned by CodeGenPrepare from the
+        // profile summary or hot/cold attributes; function sections let the
+        // linker reorder them and the splitter moves cold blocks out of line
+        opt.FunctionSections = true;
+        opt.EnableMachineFunctionSplitter = true;
+    }
     std::optional<llvm::Reloc::Model> RM = std::nullopt;
+    if (positionIndependent) {
+        RM = llvm::Reloc::PIC_;
+    }
     auto cpu = "generic";
     auto features = "";
     llvm::Triple tripleObj(targetTriple);
     
-    targetMachine = std::unique_ptr<llvm::TargetMachine>(
+    auto machine = std::unique_ptr<llvm::TargetMachine>(
         target->createTargetMachine(tripleObj, cpu, features, opt, RM));
     
-    if (!targetMachine) {
+    if (!machine) {
         LOG_ERROR("CodegenAgent: Cannot create target machine");
-        return false;
     }
     
-    return true;
+    return machine;
 }
 
-bool CodegenAgent::emitObjectFile(llvm::Module* module, const std::string& filename) {
-    LOG_INFO("CodegenAgent: Emitting object file: " + filename);
+bool CodegenAgent::initializeTarget() {
+    // Built once and shared by every emission in this session
+    if (!targetMachine) {
+        targetMachine = createTargetMachine();
+    }
+    return targetMachine != nullptr;
+}
+
+namespace {
+
+const char* formatName(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Object: return "object";
+        case OutputFormat::Assembly: return "assembly";
+        case OutputFormat::Bitcode: return "bitcode";
+        case OutputFormat::LLVM_IR: return "IR";
+    }
+    return "unknown";
+}
+
+const char* formatExtension(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::Object: return ".o";
+        case OutputFormat::Assembly: return ".s";
+        case OutputFormat::Bitcode: return ".bc";
+        case OutputFormat::LLVM_IR: return ".ll";
+    }
+    return "";
+}
+
+bool isMachineCode(OutputFormat format) {
+    return format == OutputFormat::Object || format == OutputFormat::Assembly;
+}
+
+} // namespace
+
+OutputFormat CodegenAgent::formatForFilename(const std::string& filename) {
+    llvm::StringRef ext = llvm::sys::path::extension(filename);
+    if (ext == ".ll") return OutputFormat::LLVM_IR;
+    if (ext == ".bc") return OutputFormat::Bitcode;
+    if (ext == ".s") return OutputFormat::Assembly;
+    return OutputFormat::Object;
+}
+
+std::string CodegenAgent::filenameForFormat(const std::string& filename, OutputFormat format) {
+    std::string base = filename;
+    llvm::StringRef ext = llvm::sys::path::extension(filename);
+    if (ext == ".o" || ext == ".s" || ext == ".bc" || ext == ".ll") {
+        base = base.substr(0, base.size() - ext.size());
+    }
+    return base + formatExtension(format);
+}
+
+bool CodegenAgent::emitToBuffer(llvm::Module* module, OutputFormat format,
+                                llvm::SmallVectorImpl<char>& buffer) {
+    llvm::raw_svector_ostream OS(buffer);
+    
+    if (!isMachineCode(format)) {
+        if (format == OutputFormat::Bitcode) {
+            llvm::WriteBitcodeToFile(*module, OS);
+        } else {
+            module->print(OS, nullptr);
+        }
+        return true;
+    }
     
     if (!initializeTarget()) {
         return false;
@@ -52,6 +132,21 @@ bool CodegenAgent::emitObjectFile(llvm::Module* module, const std::string& filen
     
     module->setDataLayout(targetMachine->createDataLayout());
     
+    llvm::legacy::PassManager pass;
+    llvm::CodeGenFileType fileType = format == OutputFormat::Object
+        ? llvm::CodeGenFileType::ObjectFile
+        : llvm::CodeGenFileType::AssemblyFile;
+    
+    if (targetMachine->addPassesToEmitFile(pass, OS, nullptr, fileType)) {
+        LOG_ERROR(std::string("CodegenAgent: TargetMachine cannot emit ") + formatName(format) + " file");
+        return false;
+    }
+    
+    pass.run(*module);
+    return true;
+}
+
+bool CodegenAgent::writeBuffer(const std::string& filename, llvm::StringRef data) {
     std::error_code EC;
     llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
     
@@ -60,23 +155,77 @@ bool CodegenAgent::emitObjectFile(llvm::Module* module, const std::string& filen
         return false;
     }
     
-    llvm::legacy::PassManager pass;
-    llvm::CodeGenFileType fileType = llvm::CodeGenFileType::ObjectFile;
+    // The whole output is already in memory: one write, no stream buffering
+    dest.SetUnbuffered();
+    dest.write(data.data(), data.size());
+    dest.close();
     
-    if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
-        LOG_ERROR("CodegenAgent: TargetMachine cannot emit object file");
+    if (dest.has_error()) {
+        LOG_ERROR("CodegenAgent: Cannot write file: " + dest.error().message());
+        dest.clear_error();
         return false;
     }
+    return true;
+}
+
+bool CodegenAgent::emitOutputs(llvm::Module* module,
+                               const std::vector<std::pair<OutputFormat, std::string>>& outputs,
+                               std::vector<std::string>& objectFiles, unsigned objectThreads) {
+    // IR-level outputs, then a parallel object, then the backend runs
+    auto stage = [&](OutputFormat format) {
+        if (!isMachineCode(format)) return 0;
+        return format == OutputFormat::Object && objectThreads > 1 ? 1 : 2;
+    };
+    std::vector<std::pair<OutputFormat, std::string>> ordered = outputs;
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [&](const auto& a, const auto& b) { return stage(a.first) < stage(b.first); });
     
-    pass.run(*module);
-    dest.flush();
+    size_t backendRuns = std::count_if(ordered.begin(), ordered.end(),
+                                       [&](const auto& output) { return stage(output.first) == 2; });
     
-    LOG_INFO("CodegenAgent: Object file emitted successfully");
-    return true;
+    bool succeeded = true;
+    for (const auto& [format, filename] : ordered) {
+        LOG_INFO(std::string("CodegenAgent: Emitting ") + formatName(format) + " file: " + filename);
+        
+        if (stage(format) == 1) {
+            succeeded = emitObjectFilesParallel(module, filename, objectThreads, objectFiles) && succeeded;
+            continue;
+        }
+        
+        llvm::SmallVector<char, 0> buffer;
+        bool emitted;
+        if (stage(format) == 2 && --backendRuns > 0) {
+            // Later backend runs still need the untouched IR
+            auto copy = llvm::CloneModule(*module);
+            emitted = emitToBuffer(copy.get(), format, buffer);
+        } else {
+            emitted = emitToBuffer(module, format, buffer);
+        }
+        
+        if (!emitted || !writeBuffer(filename, llvm::StringRef(buffer.data(), buffer.size()))) {
+            succeeded = false;
+            continue;
+        }
+        if (format == OutputFormat::Object) {
+            objectFiles.push_back(filename);
+        }
+        LOG_INFO("CodegenAgent: Wrote " + std::to_string(buffer.size()) + " bytes to " + filename);
+    }
+    
+    return succeeded;
+}
+
+bool CodegenAgent::emitObjectFile(llvm::Module* module, const std::string& filename) {
+    return emit(module, filename, OutputFormat::Object);
 }
 
 bool CodegenAgent::emitAssemblyFile(llvm::Module* module, const std::string& filename) {
-    LOG_INFO("CodegenAgent: Emitting assembly file: " + filename);
+    return emit(module, filename, OutputFormat::Assembly);
+}
+
+bool CodegenAgent::emitObjectFilesParallel(llvm::Module* module, const std::string& filename,
+                                           unsigned numThreads, std::vector<std::string>& objectFiles) {
+    LOG_INFO("CodegenAgent: Emitting object files on " + std::to_string(numThreads) + " threads");
     
     if (!initializeTarget()) {
         return false;
@@ -84,78 +233,200 @@ bool CodegenAgent::emitAssemblyFile(llvm::Module* module, const std::string& fil
     
     module->setDataLayout(targetMachine->createDataLayout());
     
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+    // Partitions share the input's context, so hand them to workers as bitcode
+    // and let each thread parse into its own context and TargetMachine
+    std::vector<llvm::SmallString<0>> partitions;
+    llvm::SplitModule(*module, numThreads, [&](std::unique_ptr<llvm::Module> part) {
+        partitions.emplace_back();
+        llvm::raw_svector_ostream OS(partitions.back());
+        llvm::WriteBitcodeToFile(*part, OS);
+    });
     
-    if (EC) {
-        LOG_ERROR("CodegenAgent: Cannot open file: " + EC.message());
-        return false;
+    std::string base = filename;
+    if (llvm::sys::path::extension(base) == ".o") {
+        base = base.substr(0, base.size() - 2);
     }
     
-    llvm::legacy::PassManager pass;
-    llvm::CodeGenFileType fileType = llvm::CodeGenFileType::AssemblyFile;
+    size_t first = objectFiles.size();
+    for (size_t i = 0; i < partitions.size(); i++) {
+        objectFiles.push_back(base + ".part" + std::to_string(i) + ".o");
+    }
     
-    if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)) {
-        LOG_ERROR("CodegenAgent: TargetMachine cannot emit assembly file");
-        return false;
+    std::vector<char> succeeded(partitions.size(), false);
+    llvm::DefaultThreadPool pool(llvm::hardware_concurrency(numThreads));
+    for (size_t i = 0; i < partitions.size(); i++) {
+        pool.async([&, i]() {
+            llvm::LLVMContext partContext;
+            auto part = llvm::parseBitcodeFile(
+                llvm::MemoryBufferRef(partitions[i], "partition" + std::to_string(i)), partContext);
+            if (!part) {
+                llvm::consumeError(part.takeError());
+                LOG_ERROR("CodegenAgent: Cannot read partition " + std::to_string(i));
+                return;
+            }
+            
+            auto machine = createTargetMachine();
+            if (!machine) {
+                return;
+            }
+            
+            llvm::SmallVector<char, 0> buffer;
+            llvm::raw_svector_ostream OS(buffer);
+            llvm::legacy::PassManager pass;
+            if (machine->addPassesToEmitFile(pass, OS, nullptr, llvm::CodeGenFileType::ObjectFile)) {
+                LOG_ERROR("CodegenAgent: TargetMachine cannot emit object file");
+                return;
+            }
+            
+            pass.run(**part);
+            if (!writeBuffer(objectFiles[first + i], llvm::StringRef(buffer.data(), buffer.size()))) {
+                return;
+            }
+            succeeded[i] = true;
+        });
     }
+    pool.wait();
     
-    pass.run(*module);
-    dest.flush();
+    if (std::find(succeeded.begin(), succeeded.end(), false) != succeeded.end()) {
+        LOG_ERROR("CodegenAgent: Parallel code generation failed");
+        return false;
+    }
     
-    LOG_INFO("CodegenAgent: Assembly file emitted successfully");
+    LOG_INFO("CodegenAgent: Emitted " + std::to_string(partitions.size()) + " object file(s)");
     return true;
 }
 
 bool CodegenAgent::emitBitcodeFile(llvm::Module* module, const std::string& filename) {
-    LOG_INFO("CodegenAgent: Emitting bitcode file: " + filename);
+    return emit(module, filename, OutputFormat::Bitcode);
+}
+
+bool CodegenAgent::emitIRFile(llvm::Module* module, const std::string& filename) {
+    return emit(module, filename, OutputFormat::LLVM_IR);
+}
+
+bool CodegenAgent::emitSymbolOrderingFile(llvm::Module* module, const std::string& filename) {
+    LOG_INFO("CodegenAgent: Emitting symbol ordering file: " + filename);
+    
+    // Hot-attributed functions first, then profiled functions by entry count
+    std::vector<std::pair<uint64_t, std::string>> ordered;
+    for (auto& func : *module) {
+        if (func.isDeclaration()) continue;
+        
+        if (func.hasFnAttribute(llvm::Attribute::Hot)) {
+            ordered.push_back({UINT64_MAX, func.getName().str()});
+        } else if (auto count = func.getEntryCount()) {
+            if (count->getCount() > 0) {
+                ordered.push_back({count->getCount(), func.getName().str()});
+            }
+        }
+    }
+    
+    if (ordered.empty()) {
+        LOG_WARNING("CodegenAgent: No hot functions found, symbol ordering file not written");
+        return false;
+    }
+    
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
     
     std::error_code EC;
-    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_Text);
     
     if (EC) {
         LOG_ERROR("CodegenAgent: Cannot open file: " + EC.message());
         return false;
     }
     
-    llvm::WriteBitcodeToFile(*module, dest);
+    for (const auto& entry : ordered) {
+        dest << entry.second << "\n";
+    }
     dest.flush();
     
-    LOG_INFO("CodegenAgent: Bitcode file emitted successfully");
+    LOG_INFO("CodegenAgent: Ordered " + std::to_string(ordered.size()) + " hot function(s)");
     return true;
 }
 
-bool CodegenAgent::emitIRFile(llvm::Module* module, const std::string& filename) {
-    LOG_INFO("CodegenAgent: Emitting IR file: " + filename);
+namespace {
+
+std::optional<std::string> toCType(llvm::Type* type) {
+    if (type->isVoidTy()) return std::string("void");
+    if (type->isIntegerTy(1)) return std::string("bool");
+    if (type->isIntegerTy(32)) return std::string("int32_t");
+    if (type->isIntegerTy(64)) return std::string("int64_t");
+    if (type->isFloatTy()) return std::string("float");
+    if (type->isDoubleTy()) return std::string("double");
+    return std::nullopt;
+}
+
+} // namespace
+
+bool CodegenAgent::emitCHeader(llvm::Module* module, const std::string& filename) {
+    LOG_INFO("CodegenAgent: Emitting C header: " + filename);
     
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+    std::string guard = "DSL_" + llvm::sys::path::filename(filename).str();
+    for (char& c : guard) {
+        c = std::isalnum(static_cast<unsigned char>(c)) ? std::toupper(static_cast<unsigned char>(c)) : '_';
+    }
     
-    if (EC) {
-        LOG_ERROR("CodegenAgent: Cannot open file: " + EC.message());
-        return false;
+    std::string declarations;
+    size_t exported = 0;
+    for (auto& func : *module) {
+        // main and compiler-internal helpers are not part of the library interface
+        if (func.isDeclaration() || !func.hasExternalLinkage() ||
+            func.getName() == "main" || func.getName().starts_with("__")) {
+            continue;
+        }
+        
+        auto returnType = toCType(func.getReturnType());
+        std::string params;
+        bool representable = returnType.has_value();
+        for (auto& arg : func.args()) {
+            auto argType = toCType(arg.getType());
+            if (!argType) {
+                representable = false;
+                break;
+            }
+            if (!params.empty()) params += ", ";
+            params += *argType;
+            if (arg.hasName()) params += " " + arg.getName().str();
+        }
+        
+        if (!representable) {
+            LOG_WARNING("CodegenAgent: No C type for signature of " + func.getName().str() + ", skipped");
+            continue;
+        }
+        
+        declarations += *returnType + " " + func.getName().str() + "(" + (params.empty() ? "void" : params) + ");\n";
+        exported++;
     }
     
-    module->print(dest, nullptr);
-    dest.flush();
+    std::string header =
+        "/* Generated by llvm_dsl_compiler from " + module->getModuleIdentifier() + ". Do not edit. */\n"
+        "#ifndef " + guard + "\n"
+        "#define " + guard + "\n"
+        "\n"
+        "#include <stdbool.h>\n"
+        "#include <stdint.h>\n"
+        "\n"
+        "#ifdef __cplusplus\n"
+        "extern \"C\" {\n"
+        "#endif\n"
+        "\n" + declarations + "\n"
+        "#ifdef __cplusplus\n"
+        "}\n"
+        "#endif\n"
+        "\n"
+        "#endif /* " + guard + " */\n";
     
-    LOG_INFO("CodegenAgent: IR file emitted successfully");
+    if (!writeBuffer(filename, header)) {
+        return false;
+    }
+    
+    LOG_INFO("CodegenAgent: Declared " + std::to_string(exported) + " function(s)");
     return true;
 }
 
 bool CodegenAgent::emit(llvm::Module* module, const std::string& filename, OutputFormat format) {
-    switch (format) {
-        case OutputFormat::Object:
-            return emitObjectFile(module, filename);
-        case OutputFormat::Assembly:
-            return emitAssemblyFile(module, filename);
-        case OutputFormat::Bitcode:
-            return emitBitcodeFile(module, filename);
-        case OutputFormat::LLVM_IR:
-            return emitIRFile(module, filename);
-        default:
-            LOG_ERROR("CodegenAgent: Unknown output format");
-            return false;
-    }
+    std::vector<std::string> objectFiles;
+    return emitOutputs(module, {{format, filename}}, objectFiles);
 }
-
@@ -0,0 +1,237 @@
+#include "agents/CompileCacheAgent.h"
+#include "utils/Logger.h"
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Bump when the layout of cached objects or the key changes
+constexpr const char* CacheFormatVersion = "dsl-objcache-1";
+
+CacheStats parseStats(llvm::StringRef text) {
+    CacheStats stats;
+    std::istringstream input(text.str());
+    std::string field;
+    uint64_t value;
+    while (input >> field >> value) {
+        if (field == "hits") stats.hits = value;
+        else if (field == "misses") stats.misses = value;
+    }
+    return stats;
+}
+
+} // namespace
+
+CompileCacheAgent::CompileCacheAgent(const std::string& cacheDir, uint64_t maxSizeBytes)
+    : cacheDir(cacheDir) {
+    // pruneCache only considers files named llvmcache-*, which is how entries are stored
+    policy.MaxSizeBytes = maxSizeBytes;
+    policy.Interval = std::chrono::seconds(60);
+}
+
+bool CompileCacheAgent::initialize() {
+    if (std::error_code EC = llvm::sys::fs::create_directories(cacheDir)) {
+        LOG_ERROR("CompileCacheAgent: Cannot create cache directory " + cacheDir + ": " + EC.message());
+        return false;
+    }
+    return true;
+}
+
+std::string CompileCacheAgent::entryPath(const std::string& key) const {
+    llvm::SmallString<128> path(cacheDir);
+    llvm::sys::path::append(path, "llvmcache-" + key);
+    return std::string(path);
+}
+
+std::string CompileCacheAgent::statsPath() const {
+    llvm::SmallString<128> path(cacheDir);
+    llvm::sys::path::append(path, "stats");
+    return std::string(path);
+}
+
+std::string CompileCacheAgent::computeKey(const std::vector<std::string>& sources,
+                                          const std::vector<std::string>& flags,
+                                          const std::string& triple) {
+    llvm::SHA256 hasher;
+    // NUL-separate every field so adjacent values cannot run together
+    auto add = [&](llvm::StringRef field) {
+        hasher.update(field);
+        hasher.update(llvm::StringRef("\0", 1));
+    };
+
+    add(CacheFormatVersion);
+    add(LLVM_VERSION_STRING);
+    add(triple);
+    add(std::to_string(flags.size()));
+    for (const auto& flag : flags) add(flag);
+    add(std::to_string(sources.size()));
+    for (const auto& source : sources) add(source);
+
+    return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+void CompileCacheAgent::touch(const std::string& path) {
+    // Refresh the access time so LRU pruning sees the entry as recently used,
+    // even on filesystems mounted noatime
+    int fd;
+    if (!llvm::sys::fs::openFileForRead(path, fd)) {
+        auto now = std::chrono::time_point_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now());
+        llvm::sys::fs::setLastAccessAndModificationTime(fd, now);
+        llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+    }
+}
+
+bool CompileCacheAgent::lookup(const std::string& key, const std::string& outputFile) {
+    std::string path = entryPath(key);
+    if (!llvm::sys::fs::exists(path)) {
+        LOG_INFO("CompileCacheAgent: Cache miss for " + key.substr(0, 16));
+        recordEvent(false);
+        return false;
+    }
+
+    touch(path);
+
+    // A copy, not a hardlink: later builds rewrite outputFile in place, which
+    // would silently change the entry under its old key. Unlink first in case
+    // outputFile is still linked to an entry
+    llvm::sys::fs::remove(outputFile);
+    if (std::error_code EC = llvm::sys::fs::copy_file(path, outputFile)) {
+        LOG_WARNING("CompileCacheAgent: Cannot materialize cached object: " + EC.message());
+        recordEvent(false);
+        return false;
+    }
+
+    LOG_INFO("CompileCacheAgent: Cache hit for " + key.substr(0, 16) + ", wrote " + outputFile);
+    recordEvent(true);
+    return true;
+}
+
+bool CompileCacheAgent::store(const std::string& key, const std::string& objectFile) {
+    auto object = llvm::MemoryBuffer::getFile(objectFile);
+    if (!object) {
+        LOG_WARNING("CompileCacheAgent: Cannot read " + objectFile + ": " + object.getError().message());
+        return false;
+    }
+
+    if (!storeBuffer(key, (*object)->getBuffer())) {
+        return false;
+    }
+
+    LOG_INFO("CompileCacheAgent: Stored " + key.substr(0, 16));
+    return true;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> CompileCacheAgent::lookupBuffer(const std::string& key) {
+    std::string path = entryPath(key);
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+        return nullptr;
+    }
+    touch(path);
+    return std::move(*buffer);
+}
+
+bool CompileCacheAgent::storeBuffer(const std::string& key, llvm::StringRef data) {
+    // The temporary name must not start with llvmcache- or pruning could remove it mid-write
+    llvm::SmallString<128> model(cacheDir);
+    llvm::sys::path::append(model, "tmp-%%%%%%%%%%%%");
+    auto temp = llvm::sys::fs::TempFile::create(model);
+    if (!temp) {
+        LOG_WARNING("CompileCacheAgent: Cannot create temporary cache file: " +
+                    llvm::toString(temp.takeError()));
+        return false;
+    }
+
+    {
+        llvm::raw_fd_ostream OS(temp->FD, /*shouldClose=*/false);
+        OS << data;
+    }
+
+    // rename() is atomic: concurrent compilers see either no entry or a complete one
+    if (llvm::Error err = temp->keep(entryPath(key))) {
+        LOG_WARNING("CompileCacheAgent: Cannot insert cache entry: " + llvm::toString(std::move(err)));
+        llvm::consumeError(temp->discard());
+        return false;
+    }
+    return true;
+}
+
+void CompileCacheAgent::prune() {
+    if (!llvm::pruneCache(cacheDir, policy)) {
+        LOG_WARNING("CompileCacheAgent: Cache pruning failed");
+    }
+}
+
+void CompileCacheAgent::recordEvent(bool hit) {
+    int fd;
+    if (llvm::sys::fs::openFileForReadWrite(statsPath(), fd, llvm::sys::fs::CD_OpenAlways,
+                                            llvm::sys::fs::OF_None)) {
+        return;
+    }
+
+    // Several compilers may share the cache; serialize the read-modify-write
+    llvm::raw_fd_ostream OS(fd, /*shouldClose=*/true);
+    if (llvm::sys::fs::lockFile(fd)) {
+        return;
+    }
+
+    CacheStats stats;
+    if (auto contents = llvm::MemoryBuffer::getOpenFile(
+            llvm::sys::fs::convertFDToNativeFileHandle(fd), statsPath(), -1)) {
+        stats = parseStats((*contents)->getBuffer());
+    }
+    if (hit) {
+        stats.hits++;
+    } else {
+        stats.misses++;
+    }
+
+    std::string text = "hits " + std::to_string(stats.hits) + "\nmisses " + std::to_string(stats.misses) + "\n";
+    OS.seek(0);
+    OS << text;
+    OS.flush();
+    llvm::sys::fs::resize_file(fd, text.size());
+    llvm::sys::fs::unlockFile(fd);
+}
+
+CacheStats CompileCacheAgent::getStats() const {
+    auto contents = llvm::MemoryBuffer::getFile(statsPath());
+    if (!contents) {
+        return CacheStats();
+    }
+    return parseStats((*contents)->getBuffer());
+}
+
+void CompileCacheAgent::printStats() const {
+    CacheStats stats = getStats();
+
+    uint64_t entries = 0;
+    uint64_t totalSize = 0;
+    std::error_code EC;
+    for (llvm::sys::fs::directory_iterator it(cacheDir, EC), end; it != end && !EC; it.increment(EC)) {
+        if (!llvm::sys::path::filename(it->path()).starts_with("llvmcache-")) continue;
+        if (auto status = it->status()) {
+            entries++;
+            totalSize += status->getSize();
+        }
+    }
+
+    uint64_t lookups = stats.hits + stats.misses;
+    std::cout << "\n=== Compile Cache ===" << std::endl;
+    std::cout << "Directory: " << cacheDir << std::endl;
+    std::cout << "Entries:   " << entries << " (" << totalSize / 1024 << " KiB)" << std::endl;
+    std::cout << "Hits:      " << stats.hits << std::endl;
+    std::cout << "Misses:    " << stats.misses << std::endl;
+    if (lookups > 0) {
+        std::cout << "Hit rate:  " << (100 * stats.hits / lookups) << "%" << std::endl;
+    }
+}
@@ -3,14 +3,41 @@
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/ThreadPool.h>
 #include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <unordered_set>
 
-IRGenerationAgent::IRGenerationAgent(llvm::LLVMContext& ctx)
+namespace {
+
+std::optional<ast::Type> toDSLType(llvm::Type* type) {
+    if (type->isVoidTy()) return ast::Type(ast::Type::Void);
+    if (type->isIntegerTy(1)) return ast::Type(ast::Type::Bool);
+    if (type->isIntegerTy(32)) return ast::Type(ast::Type::I32);
+    if (type->isIntegerTy(64)) return ast::Type(ast::Type::I64);
+    if (type->isFloatTy()) return ast::Type(ast::Type::F32);
+    if (type->isDoubleTy()) return ast::Type(ast::Type::F64);
+    return std::nullopt;
+}
+
+} // namespace
+
+IRGenerationAgent::IRGenerationAgent(llvm::LLVMContext& ctx, const std::string& moduleName)
     : context(ctx), builder(std::make_unique<llvm::IRBuilder<>>(ctx)) {
-    module = std::make_unique<llvm::Module>("DSL_Module", context);
+    module = std::make_unique<llvm::Module>(moduleName, context);
     LOG_INFO("IRGenerationAgent: Initialized");
 }
 
+void IRGenerationAgent::reportError(const std::string& message) {
+    LOG_ERROR("IRGenerationAgent: " + message);
+    errorCount++;
+}
+
 llvm::Value* IRGenerationAgent::codegenLiteral(ast::LiteralExpr* expr) {
     switch (expr->type.kind) {
         case ast::Type::I32: {
@@ -34,7 +61,7 @@ llvm::Value* IRGenerationAgent::codegenLiteral(ast::LiteralExpr* expr) {
             return llvm::ConstantInt::get(context, llvm::APInt(1, val));
         }
         default:
-            LOG_ERROR("IRGenerationAgent: Unsupported literal type");
+            reportError("Unsupported literal type");
             return nullptr;
     }
 }
@@ -42,7 +69,7 @@ llvm::Value* IRGenerationAgent::codegenLiteral(ast::LiteralExpr* expr) {
 llvm::Value* IRGenerationAgent::codegenVariable(ast::VariableExpr* expr) {
     auto it = namedValues.find(expr->name);
     if (it == namedValues.end()) {
-        LOG_ERROR("IRGenerationAgent: Unknown variable: " + expr->name);
+        reportError("Unknown variable: " + expr->name);
         return nullptr;
     }
     return it->second;
@@ -51,12 +78,12 @@ llvm::Value* IRGenerationAgent::codegenVariable(ast::VariableExpr* expr) {
 llvm::Value* IRGenerationAgent::codegenCall(ast::CallExpr* expr) {
     llvm::Function* callee = module->getFunction(expr->callee);
     if (!callee) {
-        LOG_ERROR("IRGenerationAgent: Unknown function: " + expr->callee);
+        reportError("Unknown function: " + expr->callee);
         return nullptr;
     }
     
     if (callee->arg_size() != expr->args.size()) {
-        LOG_ERROR("IRGenerationAgent: Argument count mismatch for: " + expr->callee);
+        reportError("Argument count mismatch for: " + expr->callee);
         return nullptr;
     }
     
@@ -147,7 +174,7 @@ llvm::Value* IRGenerationAgent::codegenBinaryExpr(ast::BinaryExpr* expr) {
         case ast::BinaryOp::Or:
             return builder->CreateOr(left, right, "ortmp");
         default:
-            LOG_ERROR("IRGenerationAgent: Unsupported binary operator");
+            reportError("Unsupported binary operator");
             return nullptr;
     }
 }
@@ -166,7 +193,7 @@ llvm::Value* IRGenerationAgent::codegenUnaryExpr(ast::UnaryExpr* expr) {
         case ast::UnaryOp::Not:
             return builder->CreateNot(operand, "nottmp");
         default:
-            LOG_ERROR("IRGenerationAgent: Unsupported unary operator");
+            reportError("Unsupported unary operator");
             return nullptr;
     }
 }
@@ -184,7 +211,7 @@ llvm::Value* IRGenerationAgent::codegenExpr(ast::Expr* expr) {
         case ast::ASTNodeType::Call:
             return codegenCall(static_cast<ast::CallExpr*>(expr));
         default:
-            LOG_ERROR("IRGenerationAgent: Unsupported expression type");
+            reportError("Unsupported expression type");
             return nullptr;
     }
 }
@@ -192,6 +219,10 @@ llvm::Value* IRGenerationAgent::codegenExpr(ast::Expr* expr) {
 void IRGenerationAgent::codegenReturn(ast::ReturnStmt* stmt) {
     if (stmt->expr) {
         llvm::Value* retVal = codegenExpr(stmt->expr.get());
+        if (!retVal) {
+            reportError("Failed to generate code for return statement");
+            return;
+        }
         builder->CreateRet(retVal);
     } else {
         builder->CreateRetVoid();
@@ -201,7 +232,7 @@ void IRGenerationAgent::codegenReturn(ast::ReturnStmt* stmt) {
 void IRGenerationAgent::codegenLet(ast::LetStmt* stmt) {
     llvm::Value* val = codegenExpr(stmt->value.get());
     if (!val) {
-        LOG_ERROR("IRGenerationAgent: Failed to generate code for let statement");
+        reportError("Failed to generate code for let statement");
         return;
     }
     
@@ -218,15 +249,13 @@ void IRGenerationAgent::codegenStmt(ast::Stmt* stmt) {
             codegenLet(static_cast<ast::LetStmt*>(stmt));
             break;
         default:
-            LOG_ERROR("IRGenerationAgent: Unsupported statement type");
+            reportError("Unsupported statement type");
     }
 }
 
-llvm::Function* IRGenerationAgent::codegenFunction(ast::Function* func) {
-    // Check if function already exists
+llvm::Function* IRGenerationAgent::declareFunction(ast::Function* func) {
     llvm::Function* llvmFunc = module->getFunction(func->name);
     if (llvmFunc) {
-        LOG_WARNING("IRGenerationAgent: Function already exists: " + func->name);
         return llvmFunc;
     }
     
@@ -249,6 +278,45 @@ llvm::Function* IRGenerationAgent::codegenFunction(ast::Function* func) {
         idx++;
     }
     
+    return llvmFunc;
+}
+
+std::vector<std::unique_ptr<ast::Function>> IRGenerationAgent::importPrototypes(const llvm::Module& module) {
+    std::vector<std::unique_ptr<ast::Function>> prototypes;
+    
+    for (const auto& func : module) {
+        // Lazily loaded bodies count as definitions
+        if (func.isDeclaration() || func.isIntrinsic() || func.hasLocalLinkage() || func.isVarArg()) continue;
+        
+        auto returnType = toDSLType(func.getReturnType());
+        if (!returnType) continue;
+        
+        std::vector<std::pair<std::string, ast::Type>> params;
+        for (const auto& arg : func.args()) {
+            auto argType = toDSLType(arg.getType());
+            if (!argType) break;
+            std::string name = arg.hasName() ? arg.getName().str() : "arg" + std::to_string(arg.getArgNo());
+            params.push_back({name, *argType});
+        }
+        if (params.size() != func.arg_size()) continue;
+        
+        prototypes.push_back(std::make_unique<ast::Function>(
+            func.getName().str(), *returnType, std::move(params), std::vector<std::unique_ptr<ast::Stmt>>()));
+    }
+    
+    return prototypes;
+}
+
+llvm::Function* IRGenerationAgent::codegenFunction(ast::Function* func) {
+    // Check if function already exists
+    llvm::Function* llvmFunc = module->getFunction(func->name);
+    if (llvmFunc && !llvmFunc->isDeclaration()) {
+        reportError("Redefinition of function: " + func->name);
+        return nullptr;
+    }
+    
+    llvmFunc = declareFunction(func);
+    
     // Create basic block
     llvm::BasicBlock* bb = llvm::BasicBlock::Create(context, "entry", llvmFunc);
     builder->SetInsertPoint(bb);
@@ -274,13 +342,191 @@ llvm::Function* IRGenerationAgent::codegenFunction(ast::Function* func) {
     return llvmFunc;
 }
 
-void IRGenerationAgent::generate(ast::Program* program) {
+void IRGenerationAgent::inferAttributes(const ast::CallGraph& callGraph) {
+    // Bottom-up over SCCs: callee attributes are final before their callers are
+    // visited. Calls to functions outside the program are treated conservatively.
+    std::unordered_set<ast::Function*> noUnwind;
+    std::unordered_set<ast::Function*> noRecurse;
+    
+    for (const auto& component : callGraph.getSCCs()) {
+        std::unordered_set<ast::Function*> members(component.begin(), component.end());
+        bool componentNoUnwind = true;
+        for (ast::Function* func : component) {
+            for (const auto& callee : callGraph.getCallees(func)) {
+                ast::Function* target = callGraph.lookup(callee);
+                if (!target || (!members.count(target) && !noUnwind.count(target))) {
+                    componentNoUnwind = false;
+                }
+            }
+        }
+        
+        for (ast::Function* func : component) {
+            if (componentNoUnwind) {
+                noUnwind.insert(func);
+            }
+            
+            bool funcNoRecurse = !callGraph.isRecursive(func);
+            for (const auto& callee : callGraph.getCallees(func)) {
+                ast::Function* target = callGraph.lookup(callee);
+                if (!target || !noRecurse.count(target)) {
+                    funcNoRecurse = false;
+                }
+            }
+            if (funcNoRecurse) {
+                noRecurse.insert(func);
+            }
+            
+            llvm::Function* llvmFunc = module->getFunction(func->name);
+            if (!llvmFunc || llvmFunc->isDeclaration()) continue;
+            if (componentNoUnwind) llvmFunc->addFnAttr(llvm::Attribute::NoUnwind);
+            if (funcNoRecurse) llvmFunc->addFnAttr(llvm::Attribute::NoRecurse);
+        }
+    }
+}
+
+bool IRGenerationAgent::generate(ast::Program* program) {
     LOG_INFO("IRGenerationAgent: Generating LLVM IR");
     
+    // Phase 1: declare every prototype so calls can refer to functions defined later
+    std::unordered_set<std::string> defined;
+    std::unordered_set<ast::Function*> duplicates;
     for (const auto& func : program->functions) {
-        codegenFunction(func.get());
+        if (!defined.insert(func->name).second) {
+            reportError("Redefinition of function: " + func->name);
+            duplicates.insert(func.get());
+            continue;
+        }
+        declareFunction(func.get());
+    }
+    
+    // Phase 2: generate bodies bottom-up, callees before callers
+    ast::CallGraph callGraph(program);
+    for (const auto& component : callGraph.getSCCs()) {
+        for (ast::Function* func : component) {
+            if (!duplicates.count(func)) {
+                codegenFunction(func);
+            }
+        }
     }
+    inferAttributes(callGraph);
     
     LOG_INFO("IRGenerationAgent: IR generation completed");
+    return errorCount == 0;
+}
+
+std::vector<llvm::orc::ThreadSafeModule> IRGenerationAgent::generateShards(
+    ast::Program* program, const std::vector<ast::Function*>& externals,
+    const std::string& moduleName, unsigned numShards) {
+    numShards = std::max(1u, std::min<unsigned>(numShards, program->functions.size()));
+    LOG_INFO("IRGenerationAgent: Generating LLVM IR in " + std::to_string(numShards) + " shard(s)");
+    
+    // Mutually recursive functions stay together; shards are balanced by body
+    // size, largest components first
+    ast::CallGraph callGraph(program);
+    std::vector<std::pair<size_t, const std::vector<ast::Function*>*>> units;
+    for (const auto& component : callGraph.getSCCs()) {
+        size_t size = 0;
+        for (ast::Function* func : component) {
+            size += func->body.size() + 1;
+        }
+        units.push_back({size, &component});
+    }
+    std::stable_sort(units.begin(), units.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first;
+    });
+    
+    std::vector<std::vector<ast::Function*>> assignments(numShards);
+    std::vector<size_t> load(numShards, 0);
+    for (const auto& unit : units) {
+        size_t target = std::min_element(load.begin(), load.end()) - load.begin();
+        assignments[target].insert(assignments[target].end(), unit.second->begin(), unit.second->end());
+        load[target] += unit.first;
+    }
+    
+    std::vector<llvm::orc::ThreadSafeModule> shards(numShards);
+    std::vector<size_t> shardErrors(numShards, 0);
+    llvm::DefaultThreadPool pool(llvm::hardware_concurrency(numShards));
+    
+    for (unsigned i = 0; i < numShards; i++) {
+        pool.async([&, i]() {
+            auto shardContext = std::make_unique<llvm::LLVMContext>();
+            IRGenerationAgent agent(*shardContext, moduleName + ".shard" + std::to_string(i));
+            
+            std::unordered_set<ast::Function*> owned(assignments[i].begin(), assignments[i].end());
+            for (const auto& func : program->functions) {
+                if (!owned.count(func.get())) {
+                    agent.declareFunction(func.get());
+                }
+            }
+            for (ast::Function* func : externals) {
+                agent.declareFunction(func);
+            }
+            for (ast::Function* func : assignments[i]) {
+                agent.codegenFunction(func);
+            }
+            agent.inferAttributes(callGraph);
+            
+            shardErrors[i] = agent.errorCount;
+            shards[i] = llvm::orc::ThreadSafeModule(agent.takeModule(), std::move(shardContext));
+        });
+    }
+    pool.wait();
+    
+    // Shards are only usable together, so one failed function fails the program
+    size_t errors = std::accumulate(shardErrors.begin(), shardErrors.end(), size_t(0));
+    if (errors > 0) {
+        LOG_ERROR("IRGenerationAgent: " + std::to_string(errors) + " error(s) in parallel IR generation");
+        return {};
+    }
+    return shards;
 }
 
+std::unique_ptr<llvm::Module> IRGenerationAgent::linkShards(
+    std::vector<llvm::orc::ThreadSafeModule>& shards, llvm::LLVMContext& ctx,
+    const std::string& moduleName) {
+    // Shards live in their own contexts, so move them across as bitcode
+    std::vector<llvm::SmallString<0>> buffers(shards.size());
+    llvm::DefaultThreadPool pool(llvm::hardware_concurrency(shards.size()));
+    for (size_t i = 0; i < shards.size(); i++) {
+        pool.async([&, i]() {
+            shards[i].withModuleDo([&](llvm::Module& shard) {
+                llvm::raw_svector_ostream OS(buffers[i]);
+                llvm::WriteBitcodeToFile(shard, OS);
+            });
+        });
+    }
+    pool.wait();
+    shards.clear();
+    
+    auto merged = std::make_unique<llvm::Module>(moduleName, ctx);
+    llvm::Linker linker(*merged);
+    for (size_t i = 0; i < buffers.size(); i++) {
+        auto shard = llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(buffers[i], moduleName + ".shard" + std::to_string(i)), ctx);
+        if (!shard) {
+            LOG_ERROR("IRGenerationAgent: Cannot read shard " + std::to_string(i));
+            llvm::logAllUnhandledErrors(shard.takeError(), llvm::errs(), "IRGen Error: ");
+            return nullptr;
+        }
+        if (linker.linkInModule(std::move(*shard))) {
+            LOG_ERROR("IRGenerationAgent: Failed to link shard " + std::to_string(i));
+            return nullptr;
+        }
+    }
+    
+    return merged;
+}
+
+std::unique_ptr<llvm::Module> IRGenerationAgent::generateParallel(
+    ast::Program* program, const std::vector<ast::Function*>& externals,
+    llvm::LLVMContext& ctx, const std::string& moduleName, unsigned numThreads) {
+    auto shards = generateShards(program, externals, moduleName, numThreads);
+    if (shards.empty()) {
+        return nullptr;
+    }
+    auto merged = linkShards(shards, ctx, moduleName);
+    if (merged) {
+        LOG_INFO("IRGenerationAgent: IR generation completed");
+    }
+    return merged;
+}
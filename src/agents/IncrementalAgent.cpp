@@ -0,0 +1,135 @@
+#include "agents/IncrementalAgent.h"
+#include "agents/ASTAgent.h"
+#include "ast/CallGraph.h"
+#include "utils/Logger.h"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <set>
+
+IncrementalAgent::IncrementalAgent(CompileCacheAgent& cache, std::vector<std::string> flags, std::string triple)
+    : cache(cache), flags(std::move(flags)), triple(std::move(triple)) {
+}
+
+void IncrementalAgent::computeKeys(const std::vector<ast::Program*>& programs) {
+    std::unordered_map<std::string, std::string> fingerprints;
+    std::unordered_map<std::string, std::vector<std::string>> callees;
+    for (ast::Program* program : programs) {
+        ast::CallGraph callGraph(program);
+        for (const auto& func : program->functions) {
+            fingerprints[func->name] = ASTAgent::fingerprint(func.get());
+            callees[func->name] = callGraph.getCallees(func.get());
+        }
+    }
+    
+    for (const auto& entry : fingerprints) {
+        // Anything reachable through calls may be inlined into this function,
+        // including callees defined in other input files
+        std::set<std::string> reachable = {entry.first};
+        std::vector<std::string> worklist = {entry.first};
+        while (!worklist.empty()) {
+            std::string current = worklist.back();
+            worklist.pop_back();
+            for (const auto& callee : callees[current]) {
+                if (fingerprints.count(callee) && reachable.insert(callee).second) {
+                    worklist.push_back(callee);
+                }
+            }
+        }
+        
+        std::vector<std::string> parts;
+        for (const auto& name : reachable) {
+            parts.push_back(fingerprints[name]);
+        }
+        std::vector<std::string> keyFlags = flags;
+        keyFlags.push_back("function=" + entry.first);
+        functionKeys[entry.first] = "fn-" + CompileCacheAgent::computeKey(parts, keyFlags, triple);
+    }
+}
+
+void IncrementalAgent::prepare(llvm::Module* module) {
+    LOG_INFO("IncrementalAgent: Looking up cached functions");
+    
+    size_t defined = 0;
+    for (auto& func : *module) {
+        if (func.isDeclaration()) continue;
+        defined++;
+        
+        auto key = functionKeys.find(func.getName().str());
+        if (key == functionKeys.end()) continue;
+        
+        auto buffer = cache.lookupBuffer(key->second);
+        if (!buffer) continue;
+        
+        auto cached = llvm::parseBitcodeFile(buffer->getMemBufferRef(), module->getContext());
+        if (!cached) {
+            llvm::consumeError(cached.takeError());
+            LOG_WARNING("IncrementalAgent: Ignoring unreadable cache entry for " + func.getName().str());
+            continue;
+        }
+        
+        llvm::Function* cachedFunc = (*cached)->getFunction(func.getName());
+        if (!cachedFunc || cachedFunc->isDeclaration() ||
+            cachedFunc->getFunctionType() != func.getFunctionType()) {
+            continue;
+        }
+        
+        // Keep the fresh body visible to the inliner; it is dropped after optimization
+        func.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+        cachedFunctions[func.getName().str()] = std::move(*cached);
+    }
+    
+    reusedCount = cachedFunctions.size();
+    LOG_INFO("IncrementalAgent: Reusing " + std::to_string(reusedCount) + " of " +
+             std::to_string(defined) + " function(s), recompiling the rest");
+}
+
+bool IncrementalAgent::finish(llvm::Module* module) {
+    size_t stored = 0;
+    for (auto& func : *module) {
+        if (func.isDeclaration() || cachedFunctions.count(func.getName().str())) continue;
+        
+        auto key = functionKeys.find(func.getName().str());
+        if (key == functionKeys.end()) continue;
+        
+        // One fragment per function: its body, module-local data it may use,
+        // linkonce_odr library code (which may be dropped from later builds
+        // once nothing else calls it) and declarations for everything else
+        llvm::ValueToValueMapTy vmap;
+        auto fragment = llvm::CloneModule(*module, vmap, [&](const llvm::GlobalValue* value) {
+            return value == &func || value->hasLinkOnceODRLinkage() ||
+                   (llvm::isa<llvm::GlobalVariable>(value) && value->hasLocalLinkage());
+        });
+        
+        llvm::SmallString<0> bitcode;
+        llvm::raw_svector_ostream OS(bitcode);
+        llvm::WriteBitcodeToFile(*fragment, OS);
+        if (cache.storeBuffer(key->second, bitcode)) {
+            stored++;
+        }
+    }
+    
+    for (const auto& entry : cachedFunctions) {
+        if (llvm::Function* func = module->getFunction(entry.first)) {
+            if (!func->isDeclaration()) {
+                func->deleteBody();
+            }
+            func->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+    
+    llvm::Linker linker(*module);
+    for (auto& entry : cachedFunctions) {
+        if (linker.linkInModule(std::move(entry.second))) {
+            LOG_ERROR("IncrementalAgent: Cannot link cached definition of " + entry.first);
+            return false;
+        }
+    }
+    cachedFunctions.clear();
+    
+    LOG_INFO("IncrementalAgent: Cached " + std::to_string(stored) + " recompiled function(s), linked " +
+             std::to_string(reusedCount) + " cached definition(s)");
+    return true;
+}
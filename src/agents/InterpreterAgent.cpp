@@ -0,0 +1,600 @@
+#include "agents/InterpreterAgent.h"
+#include "utils/Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+// Deep enough for any real program; recursion can only end here, since
+// functions have no branches
+constexpr unsigned MaxCallDepth = 10000;
+
+constexpr uint64_t Recursive = std::numeric_limits<uint64_t>::max();
+
+bool isInteger(ast::Type::Kind kind) {
+    return kind == ast::Type::I32 || kind == ast::Type::I64 || kind == ast::Type::Bool;
+}
+
+bool isComparison(ast::BinaryOp op) {
+    return op >= ast::BinaryOp::Eq && op <= ast::BinaryOp::Ge;
+}
+
+// Integers are widened with sign extension (i1 true is -1, as icmp slt sees
+// it) and truncated back, which gives the IR's wrapping arithmetic
+int64_t loadInt(const InvocationSlot& slot, ast::Type::Kind kind) {
+    switch (kind) {
+        case ast::Type::I32:
+            return slot.i32;
+        case ast::Type::I64:
+            return slot.i64;
+        default:
+            return slot.b ? -1 : 0;
+    }
+}
+
+InvocationSlot storeInt(uint64_t value, ast::Type::Kind kind) {
+    InvocationSlot slot = {};
+    switch (kind) {
+        case ast::Type::I32:
+            slot.i32 = static_cast<int32_t>(static_cast<uint32_t>(value));
+            break;
+        case ast::Type::I64:
+            slot.i64 = static_cast<int64_t>(value);
+            break;
+        default:
+            slot.b = value & 1;
+            break;
+    }
+    return slot;
+}
+
+InvocationSlot storeBool(bool value) {
+    InvocationSlot slot = {};
+    slot.b = value;
+    return slot;
+}
+
+InvocationSlot integerBinary(ast::BinaryOp op, ast::Type::Kind kind, int64_t a, int64_t b) {
+    uint64_t ua = static_cast<uint64_t>(a), ub = static_cast<uint64_t>(b);
+    int64_t minimum = kind == ast::Type::I32 ? INT32_MIN : kind == ast::Type::I64 ? INT64_MIN : -1;
+    switch (op) {
+        case ast::BinaryOp::Add:
+            return storeInt(ua + ub, kind);
+        case ast::BinaryOp::Sub:
+            return storeInt(ua - ub, kind);
+        case ast::BinaryOp::Mul:
+            return storeInt(ua * ub, kind);
+        case ast::BinaryOp::Div:
+        case ast::BinaryOp::Mod:
+            // Undefined in the IR (sdiv/srem), so the interpreter stops instead
+            if (b == 0) {
+                throw std::runtime_error("division by zero");
+            }
+            if (a == minimum && b == -1) {
+                throw std::runtime_error("signed division overflow");
+            }
+            return storeInt(static_cast<uint64_t>(op == ast::BinaryOp::Div ? a / b : a % b), kind);
+        case ast::BinaryOp::Eq:
+            return storeBool(a == b);
+        case ast::BinaryOp::Ne:
+            return storeBool(a != b);
+        case ast::BinaryOp::Lt:
+            return storeBool(a < b);
+        case ast::BinaryOp::Le:
+            return storeBool(a <= b);
+        case ast::BinaryOp::Gt:
+            return storeBool(a > b);
+        case ast::BinaryOp::Ge:
+            return storeBool(a >= b);
+        case ast::BinaryOp::And:
+            return storeInt(ua & ub, kind);
+        case ast::BinaryOp::Or:
+            return storeInt(ua | ub, kind);
+    }
+    return {};
+}
+
+// Comparisons are ordered: any comparison with NaN is false, != included
+template <typename T>
+InvocationSlot floatBinary(ast::BinaryOp op, T a, T b) {
+    InvocationSlot slot = {};
+    T value = 0;
+    switch (op) {
+        case ast::BinaryOp::Add:
+            value = a + b;
+            break;
+        case ast::BinaryOp::Sub:
+            value = a - b;
+            break;
+        case ast::BinaryOp::Mul:
+            value = a * b;
+            break;
+        case ast::BinaryOp::Div:
+            value = a / b;
+            break;
+        case ast::BinaryOp::Mod:
+            value = std::fmod(a, b);
+            break;
+        case ast::BinaryOp::Eq:
+            return storeBool(a == b);
+        case ast::BinaryOp::Ne:
+            return storeBool(a < b || a > b);
+        case ast::BinaryOp::Lt:
+            return storeBool(a < b);
+        case ast::BinaryOp::Le:
+            return storeBool(a <= b);
+        case ast::BinaryOp::Gt:
+            return storeBool(a > b);
+        case ast::BinaryOp::Ge:
+            return storeBool(a >= b);
+        default:
+            return slot;
+    }
+    if constexpr (sizeof(T) == sizeof(float)) {
+        slot.f32 = value;
+    } else {
+        slot.f64 = value;
+    }
+    return slot;
+}
+
+InvocationSlot i32(int32_t value) {
+    InvocationSlot slot = {};
+    slot.i32 = value;
+    return slot;
+}
+
+InvocationSlot i64(int64_t value) {
+    InvocationSlot slot = {};
+    slot.i64 = value;
+    return slot;
+}
+
+InvocationSlot f32(float value) {
+    InvocationSlot slot = {};
+    slot.f32 = value;
+    return slot;
+}
+
+InvocationSlot f64(double value) {
+    InvocationSlot slot = {};
+    slot.f64 = value;
+    return slot;
+}
+
+// llvm.abs without poison: the minimum value is its own absolute value
+template <typename T>
+T wrappingAbs(T value) {
+    using U = std::make_unsigned_t<T>;
+    return value < 0 ? static_cast<T>(U(0) - static_cast<U>(value)) : value;
+}
+
+// Product of [lo, hi) modulo 2^64. Stops once the product is zero, which any
+// range of more than 128 values reaches
+int64_t productRange(int64_t lo, int64_t hi) {
+    uint64_t product = 1;
+    for (int64_t i = lo; i < hi && product != 0; i++) {
+        product *= static_cast<uint64_t>(i);
+    }
+    return static_cast<int64_t>(product);
+}
+
+} // namespace
+
+// Same results as stdlib/stdlib.ll, including its wrapping and NaN handling
+const std::vector<InterpreterAgent::Native>& InterpreterAgent::natives() {
+    using K = ast::Type::Kind;
+    static const std::vector<Native> table = {
+        {"abs_i32", K::I32, {K::I32}, [](const InvocationSlot* a) { return i32(wrappingAbs(a[0].i32)); }},
+        {"abs_i64", K::I64, {K::I64}, [](const InvocationSlot* a) { return i64(wrappingAbs(a[0].i64)); }},
+        {"min_i32", K::I32, {K::I32, K::I32},
+         [](const InvocationSlot* a) { return i32(std::min(a[0].i32, a[1].i32)); }},
+        {"max_i32", K::I32, {K::I32, K::I32},
+         [](const InvocationSlot* a) { return i32(std::max(a[0].i32, a[1].i32)); }},
+        {"min_i64", K::I64, {K::I64, K::I64},
+         [](const InvocationSlot* a) { return i64(std::min(a[0].i64, a[1].i64)); }},
+        {"max_i64", K::I64, {K::I64, K::I64},
+         [](const InvocationSlot* a) { return i64(std::max(a[0].i64, a[1].i64)); }},
+        {"clamp_i32", K::I32, {K::I32, K::I32, K::I32},
+         [](const InvocationSlot* a) { return i32(std::min(std::max(a[0].i32, a[1].i32), a[2].i32)); }},
+        {"clamp_i64", K::I64, {K::I64, K::I64, K::I64},
+         [](const InvocationSlot* a) { return i64(std::min(std::max(a[0].i64, a[1].i64), a[2].i64)); }},
+        {"pow_i64", K::I64, {K::I64, K::I64},
+         [](const InvocationSlot* a) {
+             if (a[1].i64 < 0) return i64(0);
+             uint64_t base = static_cast<uint64_t>(a[0].i64), result = 1;
+             for (uint64_t exp = static_cast<uint64_t>(a[1].i64); exp; exp >>= 1) {
+                 if (exp & 1) result *= base;
+                 base *= base;
+             }
+             return i64(static_cast<int64_t>(result));
+         }},
+        {"gcd_i64", K::I64, {K::I64, K::I64},
+         [](const InvocationSlot* a) {
+             uint64_t x = static_cast<uint64_t>(wrappingAbs(a[0].i64));
+             uint64_t y = static_cast<uint64_t>(wrappingAbs(a[1].i64));
+             while (y) {
+                 uint64_t r = x % y;
+                 x = y;
+                 y = r;
+             }
+             return i64(static_cast<int64_t>(x));
+         }},
+        // Closed form n*lo + n(n-1)/2 modulo 2^64; the even factor is halved first
+        {"sum_range_i64", K::I64, {K::I64, K::I64},
+         [](const InvocationSlot* a) {
+             if (a[1].i64 <= a[0].i64) return i64(0);
+             uint64_t n = static_cast<uint64_t>(a[1].i64) - static_cast<uint64_t>(a[0].i64);
+             uint64_t triangle = n % 2 == 0 ? (n / 2) * (n - 1) : n * ((n - 1) / 2);
+             return i64(static_cast<int64_t>(n * static_cast<uint64_t>(a[0].i64) + triangle));
+         }},
+        {"product_range_i64", K::I64, {K::I64, K::I64},
+         [](const InvocationSlot* a) { return i64(productRange(a[0].i64, a[1].i64)); }},
+        {"factorial_i64", K::I64, {K::I64},
+         [](const InvocationSlot* a) {
+             return i64(productRange(1, static_cast<int64_t>(static_cast<uint64_t>(a[0].i64) + 1)));
+         }},
+        {"abs_f64", K::F64, {K::F64}, [](const InvocationSlot* a) { return f64(std::fabs(a[0].f64)); }},
+        {"min_f64", K::F64, {K::F64, K::F64},
+         [](const InvocationSlot* a) { return f64(std::fmin(a[0].f64, a[1].f64)); }},
+        {"max_f64", K::F64, {K::F64, K::F64},
+         [](const InvocationSlot* a) { return f64(std::fmax(a[0].f64, a[1].f64)); }},
+        {"clamp_f64", K::F64, {K::F64, K::F64, K::F64},
+         [](const InvocationSlot* a) { return f64(std::fmin(std::fmax(a[0].f64, a[1].f64), a[2].f64)); }},
+        {"sqrt_f64", K::F64, {K::F64}, [](const InvocationSlot* a) { return f64(std::sqrt(a[0].f64)); }},
+        {"floor_f64", K::F64, {K::F64}, [](const InvocationSlot* a) { return f64(std::floor(a[0].f64)); }},
+        {"ceil_f64", K::F64, {K::F64}, [](const InvocationSlot* a) { return f64(std::ceil(a[0].f64)); }},
+        {"fma_f64", K::F64, {K::F64, K::F64, K::F64},
+         [](const InvocationSlot* a) { return f64(std::fma(a[0].f64, a[1].f64, a[2].f64)); }},
+        {"sqrt_f32", K::F32, {K::F32}, [](const InvocationSlot* a) { return f32(std::sqrt(a[0].f32)); }},
+        {"abs_f32", K::F32, {K::F32}, [](const InvocationSlot* a) { return f32(std::fabs(a[0].f32)); }},
+    };
+    return table;
+}
+
+bool InterpreterAgent::load(const std::vector<std::unique_ptr<ast::Program>>& programs) {
+    functions.clear();
+    functionIndex.clear();
+    for (const auto& program : programs) {
+        for (const auto& func : program->functions) {
+            if (!functionIndex.emplace(func->name, static_cast<uint32_t>(functions.size())).second) {
+                LOG_ERROR("InterpreterAgent: Redefinition of function: " + func->name);
+                return false;
+            }
+            CompiledFunction compiled;
+            compiled.source = func.get();
+            functions.push_back(std::move(compiled));
+        }
+    }
+    
+    // Callees are all known before any body is resolved
+    for (auto& function : functions) {
+        if (!compile(function)) {
+            LOG_ERROR("InterpreterAgent: Cannot interpret " + function.source->name);
+            return false;
+        }
+    }
+    LOG_INFO("InterpreterAgent: Loaded " + std::to_string(functions.size()) + " functions");
+    return true;
+}
+
+bool InterpreterAgent::compile(CompiledFunction& function) {
+    const ast::Function& source = *function.source;
+    std::map<std::string, std::pair<uint32_t, ast::Type::Kind>> scope;
+    for (const auto& [name, type] : source.params) {
+        scope[name] = {function.frameSize++, type.kind};
+    }
+    
+    // Statements after the first return are never reached
+    for (const auto& stmt : source.body) {
+        if (stmt->type == ast::ASTNodeType::Let) {
+            auto* let = static_cast<const ast::LetStmt*>(stmt.get());
+            int32_t node = compileExpr(function, let->value.get(), scope);
+            if (node < 0) return false;
+            // Like the IR, the name takes the value's own type
+            uint32_t slot = function.frameSize++;
+            scope[let->name] = {slot, function.nodes[node].type};
+            function.steps.push_back({false, slot, node});
+            continue;
+        }
+    
+        auto* ret = static_cast<const ast::ReturnStmt*>(stmt.get());
+        int32_t node = -1;
+        if (ret->expr) {
+            node = compileExpr(function, ret->expr.get(), scope);
+            if (node < 0) return false;
+        }
+        ast::Type::Kind type = node < 0 ? ast::Type::Void : function.nodes[node].type;
+        if (type != source.returnType.kind) {
+            LOG_ERROR("InterpreterAgent: Return type mismatch in " + source.name);
+            return false;
+        }
+        function.steps.push_back({true, 0, node});
+        return true;
+    }
+    
+    if (source.returnType.kind != ast::Type::Void) {
+        LOG_ERROR("InterpreterAgent: Function missing return statement");
+        return false;
+    }
+    return true;
+}
+
+int32_t InterpreterAgent::compileExpr(CompiledFunction& function, const ast::Expr* expr,
+                                      const std::map<std::string, std::pair<uint32_t, ast::Type::Kind>>& scope) {
+    Node node;
+    switch (expr->type) {
+        case ast::ASTNodeType::Literal: {
+            auto* literal = static_cast<const ast::LiteralExpr*>(expr);
+            node.kind = NodeKind::Constant;
+            node.type = node.operandType = literal->type.kind;
+            try {
+                switch (literal->type.kind) {
+                    case ast::Type::I32:
+                        node.constant.i32 = std::stoi(literal->value);
+                        break;
+                    case ast::Type::I64:
+                        node.constant.i64 = std::stol(literal->value);
+                        break;
+                    case ast::Type::F32:
+                        node.constant.f32 = std::stof(literal->value);
+                        break;
+                    case ast::Type::F64:
+                        node.constant.f64 = std::stod(literal->value);
+                        break;
+                    case ast::Type::Bool:
+                        node.constant.b = literal->value == "1" || literal->value == "true";
+                        break;
+                    case ast::Type::Void:
+                        LOG_ERROR("InterpreterAgent: Unsupported literal type");
+                        return -1;
+                }
+            } catch (const std::exception&) {
+                LOG_ERROR("InterpreterAgent: Invalid literal: " + literal->value);
+                return -1;
+            }
+            break;
+        }
+        case ast::ASTNodeType::Variable: {
+            auto* variable = static_cast<const ast::VariableExpr*>(expr);
+            auto it = scope.find(variable->name);
+            if (it == scope.end()) {
+                LOG_ERROR("InterpreterAgent: Unknown variable: " + variable->name);
+                return -1;
+            }
+            node.kind = NodeKind::Variable;
+            node.index = it->second.first;
+            node.type = node.operandType = it->second.second;
+            break;
+        }
+        case ast::ASTNodeType::BinaryExpr: {
+            auto* binary = static_cast<const ast::BinaryExpr*>(expr);
+            int32_t lhs = compileExpr(function, binary->left.get(), scope);
+            int32_t rhs = lhs < 0 ? -1 : compileExpr(function, binary->right.get(), scope);
+            if (rhs < 0) return -1;
+            ast::Type::Kind type = function.nodes[lhs].type;
+            bool bitwise = binary->op == ast::BinaryOp::And || binary->op == ast::BinaryOp::Or;
+            if (type != function.nodes[rhs].type || type == ast::Type::Void || (bitwise && !isInteger(type))) {
+                LOG_ERROR("InterpreterAgent: Invalid operand types for binary operator");
+                return -1;
+            }
+            node.kind = NodeKind::Binary;
+            node.op = static_cast<uint8_t>(binary->op);
+            node.operandType = type;
+            node.type = isComparison(binary->op) ? ast::Type::Bool : type;
+            node.lhs = static_cast<uint32_t>(lhs);
+            node.rhs = static_cast<uint32_t>(rhs);
+            break;
+        }
+        case ast::ASTNodeType::UnaryExpr: {
+            auto* unary = static_cast<const ast::UnaryExpr*>(expr);
+            int32_t operand = compileExpr(function, unary->operand.get(), scope);
+            if (operand < 0) return -1;
+            ast::Type::Kind type = function.nodes[operand].type;
+            if (type == ast::Type::Void || (unary->op == ast::UnaryOp::Not && !isInteger(type))) {
+                LOG_ERROR("InterpreterAgent: Invalid operand type for unary operator");
+                return -1;
+            }
+            node.kind = NodeKind::Unary;
+            node.op = static_cast<uint8_t>(unary->op);
+            node.type = node.operandType = type;
+            node.lhs = static_cast<uint32_t>(operand);
+            break;
+        }
+        case ast::ASTNodeType::Call: {
+            auto* call = static_cast<const ast::CallExpr*>(expr);
+            // Program functions shadow the standard library, as at link time
+            std::vector<ast::Type::Kind> params;
+            auto user = functionIndex.find(call->callee);
+            if (user != functionIndex.end()) {
+                const ast::Function& callee = *functions[user->second].source;
+                node.kind = NodeKind::Call;
+                node.index = user->second;
+                node.type = callee.returnType.kind;
+                for (const auto& param : callee.params) {
+                    params.push_back(param.second.kind);
+                }
+            } else {
+                const auto& table = natives();
+                size_t i = 0;
+                while (i < table.size() && call->callee != table[i].name) i++;
+                if (i == table.size()) {
+                    LOG_ERROR("InterpreterAgent: Unknown function: " + call->callee);
+                    return -1;
+                }
+                node.kind = NodeKind::Native;
+                node.index = static_cast<uint32_t>(i);
+                node.type = table[i].returnType;
+                params = table[i].params;
+            }
+            node.operandType = node.type;
+    
+            if (params.size() != call->args.size()) {
+                LOG_ERROR("InterpreterAgent: Argument count mismatch for: " + call->callee);
+                return -1;
+            }
+            std::vector<uint32_t> args;
+            for (size_t i = 0; i < call->args.size(); i++) {
+                int32_t arg = compileExpr(function, call->args[i].get(), scope);
+                if (arg < 0) return -1;
+                if (function.nodes[arg].type != params[i]) {
+                    LOG_ERROR("InterpreterAgent: Argument type mismatch for: " + call->callee);
+                    return -1;
+                }
+                args.push_back(static_cast<uint32_t>(arg));
+            }
+            node.first = static_cast<uint32_t>(function.operands.size());
+            node.count = static_cast<uint32_t>(args.size());
+            function.operands.insert(function.operands.end(), args.begin(), args.end());
+            break;
+        }
+        default:
+            LOG_ERROR("InterpreterAgent: Unsupported expression type");
+            return -1;
+    }
+    function.nodes.push_back(node);
+    return static_cast<int32_t>(function.nodes.size() - 1);
+}
+
+const ast::Function* InterpreterAgent::getFunction(const std::string& name) const {
+    auto it = functionIndex.find(name);
+    return it == functionIndex.end() ? nullptr : functions[it->second].source;
+}
+
+// state: 0 unvisited, 1 on the current path, 2 done
+uint64_t InterpreterAgent::cost(uint32_t function, std::vector<int>& state, std::vector<uint64_t>& memo) const {
+    if (state[function] == 2) return memo[function];
+    if (state[function] == 1) return Recursive;
+    state[function] = 1;
+    
+    uint64_t total = 0;
+    auto add = [&total](uint64_t value) {
+        total = value > Recursive - total ? Recursive : total + value;
+    };
+    const CompiledFunction& compiled = functions[function];
+    for (const Node& node : compiled.nodes) {
+        add(1);
+        if (node.kind == NodeKind::Call) {
+            add(cost(node.index, state, memo));
+        }
+    }
+    
+    state[function] = 2;
+    memo[function] = total;
+    return total;
+}
+
+uint64_t InterpreterAgent::estimateCost(const std::string& name) const {
+    auto it = functionIndex.find(name);
+    if (it == functionIndex.end()) return Recursive;
+    std::vector<int> state(functions.size(), 0);
+    std::vector<uint64_t> memo(functions.size(), 0);
+    return cost(it->second, state, memo);
+}
+
+bool InterpreterAgent::call(const std::string& name, const std::vector<InvocationSlot>& args, InvocationSlot& result) {
+    auto it = functionIndex.find(name);
+    if (it == functionIndex.end()) {
+        LOG_ERROR("InterpreterAgent: Unknown function: " + name);
+        return false;
+    }
+    const CompiledFunction& function = functions[it->second];
+    if (args.size() != function.source->params.size()) {
+        LOG_ERROR("InterpreterAgent: Argument count mismatch for: " + name);
+        return false;
+    }
+    
+    stack.assign(args.begin(), args.end());
+    stack.resize(function.frameSize);
+    depth = 0;
+    try {
+        result = invoke(it->second, 0);
+    } catch (const std::exception& e) {
+        LOG_ERROR("InterpreterAgent: " + name + ": " + e.what());
+        stack.clear();
+        return false;
+    }
+    stack.clear();
+    return true;
+}
+
+// The frame starts with the arguments; let bindings follow
+InvocationSlot InterpreterAgent::invoke(uint32_t index, size_t frame) {
+    if (++depth > MaxCallDepth) {
+        throw std::runtime_error("call depth limit exceeded (recursion)");
+    }
+    const CompiledFunction& function = functions[index];
+    InvocationSlot result = {};
+    for (const Step& step : function.steps) {
+        InvocationSlot value = step.node < 0 ? InvocationSlot{} : eval(function, step.node, frame);
+        if (step.isReturn) {
+            result = value;
+            break;
+        }
+        stack[frame + step.slot] = value;
+    }
+    depth--;
+    return result;
+}
+
+InvocationSlot InterpreterAgent::eval(const CompiledFunction& function, uint32_t index, size_t frame) {
+    const Node& node = function.nodes[index];
+    switch (node.kind) {
+        case NodeKind::Constant:
+            return node.constant;
+        case NodeKind::Variable:
+            return stack[frame + node.index];
+        case NodeKind::Binary: {
+            InvocationSlot a = eval(function, node.lhs, frame);
+            InvocationSlot b = eval(function, node.rhs, frame);
+            auto op = static_cast<ast::BinaryOp>(node.op);
+            switch (node.operandType) {
+                case ast::Type::F32:
+                    return floatBinary(op, a.f32, b.f32);
+                case ast::Type::F64:
+                    return floatBinary(op, a.f64, b.f64);
+                default:
+                    return integerBinary(op, node.operandType, loadInt(a, node.operandType),
+                                         loadInt(b, node.operandType));
+            }
+        }
+        case NodeKind::Unary: {
+            InvocationSlot a = eval(function, node.lhs, frame);
+            bool negate = static_cast<ast::UnaryOp>(node.op) == ast::UnaryOp::Neg;
+            switch (node.operandType) {
+                case ast::Type::F32:
+                    return f32(-a.f32);
+                case ast::Type::F64:
+                    return f64(-a.f64);
+                default: {
+                    uint64_t value = static_cast<uint64_t>(loadInt(a, node.operandType));
+                    return storeInt(negate ? 0 - value : ~value, node.operandType);
+                }
+            }
+        }
+        case NodeKind::Call: {
+            // Arguments are written straight into the callee's frame; nested
+            // calls push above it
+            size_t callee = stack.size();
+            stack.resize(callee + functions[node.index].frameSize);
+            for (uint32_t i = 0; i < node.count; i++) {
+                InvocationSlot arg = eval(function, function.operands[node.first + i], frame);
+                stack[callee + i] = arg;
+            }
+            InvocationSlot result = invoke(node.index, callee);
+            stack.resize(callee);
+            return result;
+        }
+        case NodeKind::Native: {
+            InvocationSlot args[3] = {};
+            for (uint32_t i = 0; i < node.count; i++) {
+                args[i] = eval(function, function.operands[node.first + i], frame);
+            }
+            return natives()[node.index].call(args);
+        }
+    }
+    return {};
+}
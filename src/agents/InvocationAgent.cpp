@@ -0,0 +1,149 @@
+#include "agents/InvocationAgent.h"
+#include "utils/Logger.h"
+#include <llvm/IR/IRBuilder.h>
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+bool isSlotType(llvm::Type* type) {
+    return type->isFloatTy() || type->isDoubleTy() ||
+           (type->isIntegerTy() && type->getIntegerBitWidth() <= 64);
+}
+
+} // namespace
+
+std::string InvocationAgent::trampolineName(const std::string& function) {
+    return TrampolinePrefix + function;
+}
+
+llvm::Function* InvocationAgent::createTrampoline(llvm::Function* target) {
+    llvm::Module* module = target->getParent();
+    llvm::LLVMContext& ctx = module->getContext();
+    
+    std::string name = trampolineName(target->getName().str());
+    if (llvm::Function* existing = module->getFunction(name)) {
+        return existing;
+    }
+    
+    if (!target->getReturnType()->isVoidTy() && !isSlotType(target->getReturnType())) {
+        return nullptr;
+    }
+    for (const auto& arg : target->args()) {
+        if (!isSlotType(arg.getType())) {
+            return nullptr;
+        }
+    }
+    
+    llvm::Type* ptrType = llvm::PointerType::getUnqual(ctx);
+    llvm::Type* slotType = llvm::Type::getInt64Ty(ctx);
+    auto* type = llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), {ptrType, ptrType}, false);
+    auto* trampoline = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, module);
+    trampoline->addFnAttr(llvm::Attribute::NoUnwind);
+    
+    llvm::Argument* args = trampoline->getArg(0);
+    llvm::Argument* result = trampoline->getArg(1);
+    args->setName("args");
+    result->setName("result");
+    
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(ctx, "entry", trampoline));
+    std::vector<llvm::Value*> callArgs;
+    for (const auto& arg : target->args()) {
+        llvm::Value* slot = builder.CreateConstInBoundsGEP1_64(slotType, args, arg.getArgNo());
+        callArgs.push_back(builder.CreateLoad(arg.getType(), slot));
+    }
+    
+    llvm::CallInst* call = builder.CreateCall(target, callArgs);
+    if (!target->getReturnType()->isVoidTy()) {
+        builder.CreateStore(call, result);
+    }
+    builder.CreateRetVoid();
+    
+    return trampoline;
+}
+
+void InvocationAgent::createTrampolines(llvm::Module* module) {
+    std::vector<llvm::Function*> targets;
+    for (auto& func : *module) {
+        // Library copies (linkonce_odr) are callable through the unit that defines them
+        if (func.isDeclaration() || func.hasLocalLinkage() || func.hasLinkOnceLinkage() || func.isVarArg()) continue;
+        if (func.getName().starts_with("__")) continue;
+        targets.push_back(&func);
+    }
+    
+    for (llvm::Function* func : targets) {
+        if (!createTrampoline(func)) {
+            LOG_WARNING("InvocationAgent: Cannot call " + func->getName().str() + ": unsupported signature");
+        }
+    }
+}
+
+bool InvocationAgent::parseValue(const std::string& text, ast::Type type, InvocationSlot& slot) {
+    if (text.empty()) {
+        return false;
+    }
+    
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    errno = 0;
+    
+    switch (type.kind) {
+        case ast::Type::Bool:
+            if (text == "true" || text == "1") {
+                slot.b = true;
+                return true;
+            }
+            if (text == "false" || text == "0") {
+                slot.b = false;
+                return true;
+            }
+            return false;
+        case ast::Type::I32: {
+            long long value = std::strtoll(begin, &end, 0);
+            if (value < INT32_MIN || value > INT32_MAX) return false;
+            slot.i32 = static_cast<int32_t>(value);
+            break;
+        }
+        case ast::Type::I64:
+            slot.i64 = std::strtoll(begin, &end, 0);
+            break;
+        case ast::Type::F32:
+            slot.f32 = std::strtof(begin, &end);
+            break;
+        case ast::Type::F64:
+            slot.f64 = std::strtod(begin, &end);
+            break;
+        case ast::Type::Void:
+            return false;
+    }
+    
+    return errno == 0 && *end == '\0';
+}
+
+std::string InvocationAgent::formatValue(const InvocationSlot& slot, ast::Type type) {
+    std::ostringstream out;
+    switch (type.kind) {
+        case ast::Type::Bool:
+            out << (slot.b ? "true" : "false");
+            break;
+        case ast::Type::I32:
+            out << slot.i32;
+            break;
+        case ast::Type::I64:
+            out << slot.i64;
+            break;
+        case ast::Type::F32:
+            out.precision(9);
+            out << slot.f32;
+            break;
+        case ast::Type::F64:
+            out.precision(17);
+            out << slot.f64;
+            break;
+        case ast::Type::Void:
+            break;
+    }
+    return out.str();
+}
@@ -1,20 +1,130 @@
 #include "agents/JITAgent.h"
+#include "agents/OptimizationAgent.h"
 #include "utils/Logger.h"
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/ExecutionEngine/Orc/IRPartitionLayer.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/Debugging/DebuggerSupport.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
-#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/Orc/TargetProcess/JITLoaderGDB.h>
+#include <llvm/ExecutionEngine/JITLink/JITLink.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
+#include <cstdio>
+#include <mutex>
+#include <unistd.h>
+
+namespace {
+
+// GDB registration is looked up in the executable's dynamic symbol table
+// (CMake exports it); reference the entry points so they are linked in
+LLVM_ATTRIBUTE_USED void* const debuggerSupportSymbols[] = {
+    reinterpret_cast<void*>(&llvm_orc_registerJITLoaderGDBWrapper),
+    reinterpret_cast<void*>(&llvm_orc_registerJITLoaderGDBAllocAction),
+};
+
+// Writes /tmp/perf-<pid>.map ("START SIZE name" per line, hex), which perf
+// reads to symbolize samples in JITed code without any post-processing
+class PerfMapPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
+private:
+    std::mutex mutex;
+    FILE* file = nullptr;
+    
+public:
+    PerfMapPlugin() {
+        std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+        file = std::fopen(path.c_str(), "a");
+        if (file) {
+            LOG_INFO("JITAgent: Writing perf map " + path);
+        } else {
+            LOG_WARNING("JITAgent: Cannot open " + path);
+        }
+    }
+    
+    ~PerfMapPlugin() override {
+        if (file) {
+            std::fclose(file);
+        }
+    }
+    
+    void modifyPassConfig(llvm::orc::MaterializationResponsibility&, llvm::jitlink::LinkGraph&,
+                          llvm::jitlink::PassConfiguration& config) override {
+        // After fixups every symbol has its final address
+        config.PostFixupPasses.push_back([this](llvm::jitlink::LinkGraph& graph) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!file) return llvm::Error::success();
+            for (llvm::jitlink::Symbol* symbol : graph.defined_symbols()) {
+                if (!symbol->hasName() || !symbol->isCallable() || symbol->getSize() == 0) continue;
+                std::fprintf(file, "%llx %llx %s\n",
+                             static_cast<unsigned long long>(symbol->getAddress().getValue()),
+                             static_cast<unsigned long long>(symbol->getSize()),
+                             (*symbol->getName()).str().c_str());
+            }
+            std::fflush(file);
+            return llvm::Error::success();
+        });
+    }
+    
+    llvm::Error notifyFailed(llvm::orc::MaterializationResponsibility&) override {
+        return llvm::Error::success();
+    }
+    llvm::Error notifyRemovingResources(llvm::orc::JITDylib&, llvm::orc::ResourceKey) override {
+        return llvm::Error::success();
+    }
+    void notifyTransferringResources(llvm::orc::JITDylib&, llvm::orc::ResourceKey, llvm::orc::ResourceKey) override {
+    }
+};
+
+// Settings shared by the eager, lazy and tiered JIT builders
+template <typename Builder>
+Builder& configureBuilder(Builder& builder, unsigned compileThreads, JITCacheAgent* objectCache) {
+    builder.setNumCompileThreads(compileThreads);
+    
+    if (objectCache) {
+        builder.setCompileFunctionCreator(
+            [objectCache](llvm::orc::JITTargetMachineBuilder targetBuilder)
+                -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+                objectCache->setTarget(targetBuilder.getCPU() + " " + targetBuilder.getFeatures().getString() +
+                                       " O" + std::to_string(static_cast<int>(targetBuilder.getCodeGenOptLevel())));
+                return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(targetBuilder), objectCache);
+            });
+    }
+    return builder;
+}
+
+} // namespace
 
 JITAgent::JITAgent() {
 }
 
 JITAgent::~JITAgent() {
+    tiers.reset();
+}
+
+void JITAgent::setLazy(bool enable, int optLevel) {
+    lazy = enable;
+    lazyOptLevel = optLevel;
 }
 
 bool JITAgent::initialize() {
     LOG_INFO("JITAgent: Initializing ORC JIT");
     
-    auto jitOrError = llvm::orc::LLJITBuilder().create();
+    if (lazy) {
+        return initializeLazy();
+    }
+    if (tierUpThreshold > 0) {
+        return initializeTiered();
+    }
+    
+    llvm::orc::LLJITBuilder builder;
+    auto jitOrError = configureBuilder(builder, compileThreads, objectCache).create();
     if (!jitOrError) {
         LOG_ERROR("JITAgent: Failed to create JIT instance");
         llvm::logAllUnhandledErrors(jitOrError.takeError(), llvm::errs(), "JIT Error: ");
@@ -22,11 +132,109 @@ bool JITAgent::initialize() {
     }
     
     jit = std::move(*jitOrError);
+    if (!installPlugins()) {
+        return false;
+    }
     LOG_INFO("JITAgent: ORC JIT initialized successfully");
     return true;
 }
 
-bool JITAgent::addModule(std::unique_ptr<llvm::Module> module) {
+// LLJIT's default layer is JITLink's ObjectLinkingLayer wherever JITLink
+// supports the target, with eh-frame registration already installed
+bool JITAgent::installPlugins() {
+    auto* linkingLayer = llvm::dyn_cast<llvm::orc::ObjectLinkingLayer>(&jit->getObjLinkingLayer());
+    if (!linkingLayer) {
+        if (perfMap || debuggerSupport) {
+            LOG_WARNING("JITAgent: --jit-perf-map and --jit-debug need JITLink, which this target does not use");
+        }
+        return true;
+    }
+    
+    if (perfMap) {
+        linkingLayer->addPlugin(std::make_unique<PerfMapPlugin>());
+    }
+    
+    if (debuggerSupport) {
+        if (auto err = llvm::orc::enableDebuggerSupport(*jit)) {
+            LOG_ERROR("JITAgent: Cannot enable debugger support");
+            llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+            return false;
+        }
+        LOG_INFO("JITAgent: JITed objects are registered with the GDB JIT interface");
+    }
+    return true;
+}
+
+bool JITAgent::initializeLazy() {
+    llvm::orc::LLLazyJITBuilder builder;
+    auto jitOrError = configureBuilder(builder, compileThreads, objectCache).create();
+    if (!jitOrError) {
+        LOG_ERROR("JITAgent: Failed to create lazy JIT instance");
+        llvm::logAllUnhandledErrors(jitOrError.takeError(), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    
+    lazyJit = jitOrError->get();
+    
+    // One partition per requested function; its callees stay behind stubs
+    lazyJit->setPartitionFunction(llvm::orc::IRPartitionLayer::compileRequested);
+    
+    // Partitions pass through the transform layer on their way to codegen,
+    // so only functions that actually run are optimized
+    if (lazyOptLevel > 0) {
+        int optLevel = lazyOptLevel;
+        lazyJit->getIRTransformLayer().setTransform(
+            [optLevel](llvm::orc::ThreadSafeModule partition, const llvm::orc::MaterializationResponsibility&)
+                -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+                partition.withModuleDo([optLevel](llvm::Module& module) {
+                    OptimizationAgent optAgent(optLevel);
+                    optAgent.optimize(&module);
+                });
+                return std::move(partition);
+            });
+    }
+    
+    jit = std::move(*jitOrError);
+    if (!installPlugins()) {
+        return false;
+    }
+    LOG_INFO("JITAgent: Lazy ORC JIT initialized successfully");
+    return true;
+}
+
+bool JITAgent::initializeTiered() {
+    // The baseline tier favours compile speed: no IR passes and O0 (FastISel) codegen
+    auto targetBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!targetBuilder) {
+        LOG_ERROR("JITAgent: Cannot detect host target");
+        llvm::logAllUnhandledErrors(targetBuilder.takeError(), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    targetBuilder->setCodeGenOptLevel(llvm::CodeGenOptLevel::None);
+    
+    llvm::orc::LLJITBuilder builder;
+    builder.setJITTargetMachineBuilder(std::move(*targetBuilder));
+    auto jitOrError = configureBuilder(builder, compileThreads, objectCache).create();
+    if (!jitOrError) {
+        LOG_ERROR("JITAgent: Failed to create JIT instance");
+        llvm::logAllUnhandledErrors(jitOrError.takeError(), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    jit = std::move(*jitOrError);
+    if (!installPlugins()) {
+        return false;
+    }
+    
+    tiers = std::make_unique<TierUpAgent>(*jit, tierUpThreshold);
+    if (!tiers->initialize()) {
+        return false;
+    }
+    
+    LOG_INFO("JITAgent: Tiered ORC JIT initialized (tier-up after " + std::to_string(tierUpThreshold) + " calls)");
+    return true;
+}
+
+bool JITAgent::addModule(llvm::orc::ThreadSafeModule module) {
     if (!jit) {
         LOG_ERROR("JITAgent: JIT not initialized");
         return false;
@@ -34,10 +242,15 @@ bool JITAgent::addModule(std::unique_ptr<llvm::Module> module) {
     
     LOG_INFO("JITAgent: Adding module to JIT");
     
-    llvm::orc::ThreadSafeModule tsm(std::move(module), 
-                                      std::make_unique<llvm::LLVMContext>());
+    if (tiers) {
+        return tiers->addModule(std::move(module));
+    }
+    
+    if (!lazyJit && compileThreads > 1) {
+        return addModuleSplit(std::move(module));
+    }
     
-    auto err = jit->addIRModule(std::move(tsm));
+    auto err = lazyJit ? lazyJit->addLazyIRModule(std::move(module)) : jit->addIRModule(std::move(module));
     if (err) {
         LOG_ERROR("JITAgent: Failed to add module");
         llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
@@ -48,6 +261,63 @@ bool JITAgent::addModule(std::unique_ptr<llvm::Module> module) {
     return true;
 }
 
+bool JITAgent::addModuleSplit(llvm::orc::ThreadSafeModule module) {
+    // Partitions made by SplitModule share the input's context, which would
+    // serialize their compiles on its lock; move each into a context of its own
+    std::vector<llvm::SmallString<0>> partitions;
+    module.withModuleDo([&](llvm::Module& M) {
+        llvm::SplitModule(M, compileThreads, [&](std::unique_ptr<llvm::Module> part) {
+            partitions.emplace_back();
+            llvm::raw_svector_ostream OS(partitions.back());
+            llvm::WriteBitcodeToFile(*part, OS);
+        });
+    });
+    
+    for (size_t i = 0; i < partitions.size(); i++) {
+        auto context = std::make_unique<llvm::LLVMContext>();
+        auto part = llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(partitions[i], "partition" + std::to_string(i)), *context);
+        if (!part) {
+            LOG_ERROR("JITAgent: Cannot read partition " + std::to_string(i));
+            llvm::logAllUnhandledErrors(part.takeError(), llvm::errs(), "JIT Error: ");
+            return false;
+        }
+        
+        auto err = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(*part), std::move(context)));
+        if (err) {
+            LOG_ERROR("JITAgent: Failed to add partition " + std::to_string(i));
+            llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+            return false;
+        }
+    }
+    
+    LOG_INFO("JITAgent: Module split into " + std::to_string(partitions.size()) + " partition(s)");
+    return true;
+}
+
+bool JITAgent::addObjectFile(const std::string& filename) {
+    if (!jit) {
+        LOG_ERROR("JITAgent: JIT not initialized");
+        return false;
+    }
+    
+    LOG_INFO("JITAgent: Adding object file " + filename);
+    
+    auto buffer = llvm::MemoryBuffer::getFile(filename);
+    if (!buffer) {
+        LOG_ERROR("JITAgent: Cannot read " + filename + ": " + buffer.getError().message());
+        return false;
+    }
+    
+    auto err = jit->addObjectFile(std::move(*buffer));
+    if (err) {
+        LOG_ERROR("JITAgent: Failed to add object file");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    return true;
+}
+
 void* JITAgent::getFunctionAddress(const std::string& name) {
     if (!jit) {
         LOG_ERROR("JITAgent: JIT not initialized");
@@ -64,3 +334,88 @@ void* JITAgent::getFunctionAddress(const std::string& name) {
     return reinterpret_cast<void*>(sym->getValue());
 }
 
+
+std::vector<void*> JITAgent::getFunctionAddresses(const std::vector<std::string>& names) {
+    if (!jit) {
+        LOG_ERROR("JITAgent: JIT not initialized");
+        return {};
+    }
+    
+    llvm::orc::SymbolLookupSet symbols;
+    for (const auto& name : names) {
+        symbols.add(jit->mangleAndIntern(name));
+    }
+    
+    // Every pending materializer is dispatched at once, onto the compile threads if any
+    auto& session = jit->getExecutionSession();
+    auto found = session.lookup(llvm::orc::makeJITDylibSearchOrder(&jit->getMainJITDylib()), std::move(symbols));
+    if (!found) {
+        LOG_ERROR("JITAgent: Batched lookup failed");
+        llvm::logAllUnhandledErrors(found.takeError(), llvm::errs(), "JIT Error: ");
+        return {};
+    }
+    
+    std::vector<void*> addresses;
+    for (const auto& name : names) {
+        addresses.push_back(reinterpret_cast<void*>((*found)[jit->mangleAndIntern(name)].getAddress().getValue()));
+    }
+    return addresses;
+}
+
+llvm::orc::JITDylib* JITAgent::createDylib(const std::string& name) {
+    if (!jit) {
+        LOG_ERROR("JITAgent: JIT not initialized");
+        return nullptr;
+    }
+    
+    // LLJIT links new dylibs against the process symbols, like the main dylib
+    auto dylib = jit->createJITDylib(name);
+    if (!dylib) {
+        LOG_ERROR("JITAgent: Failed to create JITDylib " + name);
+        llvm::logAllUnhandledErrors(dylib.takeError(), llvm::errs(), "JIT Error: ");
+        return nullptr;
+    }
+    return &*dylib;
+}
+
+bool JITAgent::addModule(llvm::orc::ThreadSafeModule module, llvm::orc::ResourceTrackerSP tracker) {
+    if (!jit) {
+        LOG_ERROR("JITAgent: JIT not initialized");
+        return false;
+    }
+    
+    auto err = jit->addIRModule(std::move(tracker), std::move(module));
+    if (err) {
+        LOG_ERROR("JITAgent: Failed to add module");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    return true;
+}
+
+bool JITAgent::removeModule(llvm::orc::ResourceTrackerSP tracker) {
+    // Frees the code and symbols of everything added under the tracker
+    auto err = tracker->remove();
+    if (err) {
+        LOG_ERROR("JITAgent: Failed to remove module");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    return true;
+}
+
+void* JITAgent::getFunctionAddress(llvm::orc::JITDylib& dylib, const std::string& name) {
+    if (!jit) {
+        LOG_ERROR("JITAgent: JIT not initialized");
+        return nullptr;
+    }
+    
+    auto sym = jit->lookup(dylib, name);
+    if (!sym) {
+        LOG_ERROR("JITAgent: Function not found: " + name);
+        llvm::logAllUnhandledErrors(sym.takeError(), llvm::errs(), "JIT Error: ");
+        return nullptr;
+    }
+    
+    return reinterpret_cast<void*>(sym->getValue());
+}
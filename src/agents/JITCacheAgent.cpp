@@ -0,0 +1,60 @@
+#include "agents/JITCacheAgent.h"
+#include "utils/Logger.h"
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/raw_ostream.h>
+
+JITCacheAgent::JITCacheAgent(CompileCacheAgent& cache, std::vector<std::string> flags)
+    : cache(cache), flags(std::move(flags)) {
+}
+
+void JITCacheAgent::setTarget(const std::string& description) {
+    std::lock_guard<std::mutex> lock(mutex);
+    target = description;
+}
+
+std::string JITCacheAgent::computeKey(const llvm::Module* module) {
+    // The IR reaching the compiler is already optimized, so its bitcode covers
+    // the source and every IR-level option
+    std::string bitcode;
+    {
+        llvm::raw_string_ostream OS(bitcode);
+        llvm::WriteBitcodeToFile(*module, OS);
+    }
+    
+    std::vector<std::string> keyFlags = flags;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        keyFlags.push_back("jit-target=" + target);
+    }
+    return "jit-" + CompileCacheAgent::computeKey({bitcode}, keyFlags, module->getTargetTriple().str());
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JITCacheAgent::getObject(const llvm::Module* module) {
+    std::string key = computeKey(module);
+    
+    if (auto object = cache.lookupBuffer(key)) {
+        hits++;
+        LOG_INFO("JITCacheAgent: Loaded cached object for " + module->getModuleIdentifier());
+        return object;
+    }
+    
+    misses++;
+    std::lock_guard<std::mutex> lock(mutex);
+    pendingKeys[module] = key;
+    return nullptr;
+}
+
+void JITCacheAgent::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) {
+    std::string key;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = pendingKeys.find(module);
+        if (it == pendingKeys.end()) {
+            return;
+        }
+        key = std::move(it->second);
+        pendingKeys.erase(it);
+    }
+    
+    cache.storeBuffer(key, object.getBuffer());
+}
@@ -0,0 +1,209 @@
+#include "agents/LTOAgent.h"
+#include "utils/Logger.h"
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/ModuleSummaryIndex.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/LTO/LTO.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Caching.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+
+namespace {
+
+llvm::OptimizationLevel toOptimizationLevel(int optLevel) {
+    switch (optLevel) {
+        case 0: return llvm::OptimizationLevel::O0;
+        case 1: return llvm::OptimizationLevel::O1;
+        case 3: return llvm::OptimizationLevel::O3;
+        default: return llvm::OptimizationLevel::O2;
+    }
+}
+
+llvm::CodeGenOptLevel toCodeGenOptLevel(int optLevel) {
+    switch (optLevel) {
+        case 0: return llvm::CodeGenOptLevel::None;
+        case 1: return llvm::CodeGenOptLevel::Less;
+        case 3: return llvm::CodeGenOptLevel::Aggressive;
+        default: return llvm::CodeGenOptLevel::Default;
+    }
+}
+
+template <typename BuildPipeline>
+void runPipeline(llvm::Module* module, BuildPipeline build) {
+    llvm::LoopAnalysisManager loopAM;
+    llvm::FunctionAnalysisManager functionAM;
+    llvm::CGSCCAnalysisManager cgsccAM;
+    llvm::ModuleAnalysisManager moduleAM;
+
+    llvm::PassBuilder passBuilder;
+    passBuilder.registerModuleAnalyses(moduleAM);
+    passBuilder.registerCGSCCAnalyses(cgsccAM);
+    passBuilder.registerFunctionAnalyses(functionAM);
+    passBuilder.registerLoopAnalyses(loopAM);
+    passBuilder.crossRegisterProxies(loopAM, functionAM, cgsccAM, moduleAM);
+
+    llvm::ModulePassManager modulePM = build(passBuilder);
+    modulePM.run(*module, moduleAM);
+}
+
+} // namespace
+
+LTOAgent::LTOAgent(int optLevel, unsigned numThreads)
+    : optLevel(optLevel), numThreads(numThreads) {
+}
+
+std::unique_ptr<llvm::Module> LTOAgent::linkModules(std::vector<std::unique_ptr<llvm::Module>> modules) {
+    if (modules.empty()) {
+        LOG_ERROR("LTOAgent: No modules to link");
+        return nullptr;
+    }
+
+    LOG_INFO("LTOAgent: Linking " + std::to_string(modules.size()) + " module(s)");
+
+    std::unique_ptr<llvm::Module> merged = std::move(modules.front());
+    llvm::Linker linker(*merged);
+
+    for (size_t i = 1; i < modules.size(); i++) {
+        std::string name = modules[i]->getModuleIdentifier();
+        if (linker.linkInModule(std::move(modules[i]))) {
+            LOG_ERROR("LTOAgent: Failed to link module: " + name);
+            return nullptr;
+        }
+    }
+
+    merged->setModuleIdentifier("DSL_Module");
+    LOG_INFO("LTOAgent: Modules linked successfully");
+    return merged;
+}
+
+void LTOAgent::optimizePreLink(llvm::Module* module) {
+    LOG_INFO("LTOAgent: Running pre-link pipeline on " + module->getModuleIdentifier());
+
+    llvm::OptimizationLevel level = toOptimizationLevel(optLevel);
+    runPipeline(module, [&](llvm::PassBuilder& passBuilder) {
+        return passBuilder.buildLTOPreLinkDefaultPipeline(level);
+    });
+}
+
+void LTOAgent::optimizeFullLTO(llvm::Module* module) {
+    LOG_INFO("LTOAgent: Running full LTO pipeline");
+
+    // Everything not explicitly preserved becomes internal, so helpers can be
+    // inlined across file boundaries and then dropped
+    llvm::internalizeModule(*module, [&](const llvm::GlobalValue& value) {
+        return preservedSymbols.count(value.getName().str()) > 0;
+    });
+
+    llvm::OptimizationLevel level = toOptimizationLevel(optLevel);
+    runPipeline(module, [&](llvm::PassBuilder& passBuilder) {
+        return passBuilder.buildLTODefaultPipeline(level, nullptr);
+    });
+
+    LOG_INFO("LTOAgent: Full LTO completed");
+}
+
+bool LTOAgent::emitBitcodeWithSummary(llvm::Module* module, const std::string& filename) {
+    LOG_INFO("LTOAgent: Emitting ThinLTO bitcode: " + filename);
+
+    std::error_code EC;
+    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+
+    if (EC) {
+        LOG_ERROR("LTOAgent: Cannot open file: " + EC.message());
+        return false;
+    }
+
+    llvm::ProfileSummaryInfo psi(*module);
+    llvm::ModuleSummaryIndex index = llvm::buildModuleSummaryIndex(*module, nullptr, &psi);
+    llvm::WriteBitcodeToFile(*module, dest, false, &index);
+    dest.flush();
+
+    return true;
+}
+
+bool LTOAgent::runThinLTO(std::vector<std::unique_ptr<llvm::Module>> modules,
+                          const std::string& outputPrefix,
+                          std::vector<std::string>& objectFiles) {
+    LOG_INFO("LTOAgent: Running ThinLTO on " + std::to_string(modules.size()) + " module(s)");
+
+    llvm::lto::Config config;
+    config.CPU = "generic";
+    config.OptLevel = optLevel;
+    config.CGOptLevel = toCodeGenOptLevel(optLevel);
+
+    llvm::lto::ThinBackend backend = llvm::lto::createInProcessThinBackend(
+        llvm::heavyweight_hardware_concurrency(numThreads));
+    llvm::lto::LTO lto(std::move(config), std::move(backend));
+
+    // Summaries are serialized into in-memory bitcode; the buffers must outlive the LTO run
+    std::vector<llvm::SmallString<0>> buffers(modules.size());
+    std::set<std::string> definedSymbols;
+
+    for (size_t i = 0; i < modules.size(); i++) {
+        llvm::raw_svector_ostream OS(buffers[i]);
+        llvm::ProfileSummaryInfo psi(*modules[i]);
+        llvm::ModuleSummaryIndex index = llvm::buildModuleSummaryIndex(*modules[i], nullptr, &psi);
+        llvm::WriteBitcodeToFile(*modules[i], OS, false, &index);
+
+        std::string name = modules[i]->getModuleIdentifier();
+        auto input = llvm::lto::InputFile::create(llvm::MemoryBufferRef(buffers[i], name));
+        if (!input) {
+            LOG_ERROR("LTOAgent: Cannot read bitcode for: " + name);
+            llvm::logAllUnhandledErrors(input.takeError(), llvm::errs(), "LTO Error: ");
+            return false;
+        }
+
+        std::vector<llvm::lto::SymbolResolution> resolutions;
+        for (const auto& symbol : (*input)->symbols()) {
+            llvm::lto::SymbolResolution resolution;
+            if (!symbol.isUndefined()) {
+                resolution.Prevailing = definedSymbols.insert(symbol.getName().str()).second;
+                resolution.FinalDefinitionInLinkageUnit = true;
+            }
+            resolution.VisibleToRegularObj = preservedSymbols.count(symbol.getName().str()) > 0;
+            resolutions.push_back(resolution);
+        }
+
+        if (auto err = lto.add(std::move(*input), resolutions)) {
+            LOG_ERROR("LTOAgent: Cannot add module: " + name);
+            llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "LTO Error: ");
+            return false;
+        }
+    }
+    modules.clear();
+
+    std::vector<llvm::SmallString<0>> objects(lto.getMaxTasks());
+    auto addStream = [&](unsigned task, const llvm::Twine&)
+        -> llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> {
+        return std::make_unique<llvm::CachedFileStream>(
+            std::make_unique<llvm::raw_svector_ostream>(objects[task]));
+    };
+
+    if (auto err = lto.run(addStream)) {
+        LOG_ERROR("LTOAgent: ThinLTO failed");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "LTO Error: ");
+        return false;
+    }
+
+    for (size_t task = 0; task < objects.size(); task++) {
+        if (objects[task].empty()) continue;
+
+        std::string filename = outputPrefix + ".thinlto." + std::to_string(task) + ".o";
+        std::error_code EC;
+        llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+        if (EC) {
+            LOG_ERROR("LTOAgent: Cannot open file: " + EC.message());
+            return false;
+        }
+        dest << objects[task];
+        objectFiles.push_back(filename);
+    }
+
+    LOG_INFO("LTOAgent: ThinLTO produced " + std::to_string(objectFiles.size()) + " object file(s)");
+    return true;
+}
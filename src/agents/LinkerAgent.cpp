@@ -1,30 +1,216 @@
 #include "agents/LinkerAgent.h"
 #include "utils/Logger.h"
-#include <cstdlib>
-#include <sstream>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Object/ArchiveWriter.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/VersionTuple.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
 
-bool LinkerAgent::linkWithLLD(const std::vector<std::string>& objectFiles,
-                              const std::string& outputFile,
-                              const std::vector<std::string>& libraries) {
-    LOG_INFO("LinkerAgent: Linking with lld");
+#ifdef DSL_HAVE_LLD
+#include <lld/Common/Driver.h>
+LLD_HAS_DRIVER(elf)
+#endif
+
+namespace {
+
+std::string joinArgs(const std::vector<std::string>& args) {
+    std::string joined;
+    for (const auto& arg : args) {
+        joined += " " + arg;
+    }
+    return joined;
+}
+
+bool hasFile(const std::string& dir, const char* name) {
+    llvm::SmallString<128> path(dir);
+    llvm::sys::path::append(path, name);
+    return llvm::sys::fs::exists(path);
+}
+
+std::string inDir(const std::string& dir, const char* name) {
+    llvm::SmallString<128> path(dir);
+    llvm::sys::path::append(path, name);
+    return std::string(path);
+}
+
+} // namespace
+
+std::optional<LinkerAgent::CRuntime> LinkerAgent::findCRuntime() {
+    llvm::Triple triple(llvm::sys::getProcessTriple());
+    if (!triple.isOSLinux() || !triple.isOSBinFormatELF()) {
+        return std::nullopt;
+    }
     
-    std::stringstream cmd;
-    cmd << "lld ";
+    CRuntime runtime;
+    switch (triple.getArch()) {
+        case llvm::Triple::x86_64:
+            runtime.dynamicLinker = "/lib64/ld-linux-x86-64.so.2";
+            break;
+        case llvm::Triple::aarch64:
+            runtime.dynamicLinker = "/lib/ld-linux-aarch64.so.1";
+            break;
+        default:
+            return std::nullopt;
+    }
+    if (!llvm::sys::fs::exists(runtime.dynamicLinker)) {
+        return std::nullopt;
+    }
     
-    for (const auto& obj : objectFiles) {
-        cmd << obj << " ";
+    // Debian-style multiarch directories first, then the Red Hat and plain layouts
+    std::string multiarch = triple.getArchName().str() + "-linux-gnu";
+    for (const std::string& dir : {"/usr/lib/" + multiarch, "/lib/" + multiarch,
+                                   std::string("/usr/lib64"), std::string("/usr/lib")}) {
+        if (hasFile(dir, "crt1.o") && hasFile(dir, "crti.o") && hasFile(dir, "crtn.o")) {
+            runtime.crtDir = dir;
+            break;
+        }
+    }
+    if (runtime.crtDir.empty()) {
+        return std::nullopt;
     }
     
-    for (const auto& lib : libraries) {
-        cmd << "-l" << lib << " ";
+    // crtbegin.o/crtend.o and libgcc live in the newest GCC's private directory
+    llvm::VersionTuple newest;
+    for (const std::string& base : {"/usr/lib/gcc/" + multiarch, "/usr/lib/gcc/" + triple.str(),
+                                    "/usr/lib64/gcc/" + multiarch}) {
+        std::error_code EC;
+        for (llvm::sys::fs::directory_iterator it(base, EC), end; it != end && !EC; it.increment(EC)) {
+            llvm::VersionTuple version;
+            if (version.tryParse(llvm::sys::path::filename(it->path())) || version <= newest) continue;
+            if (hasFile(it->path(), "crtbegin.o") && hasFile(it->path(), "crtend.o")) {
+                newest = version;
+                runtime.gccDir = it->path();
+            }
+        }
+    }
+    
+    return runtime;
+}
+
+bool LinkerAgent::runLLD(const std::vector<std::string>& args) {
+#ifdef DSL_HAVE_LLD
+    LOG_INFO("LinkerAgent: Running in-process: ld.lld" + joinArgs(args));
+    
+    std::vector<const char*> argv = {"ld.lld"};
+    for (const auto& arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    
+    std::string output;
+    std::string errors;
+    llvm::raw_string_ostream outputStream(output);
+    llvm::raw_string_ostream errorStream(errors);
+    lld::Result result = lld::lldMain(argv, outputStream, errorStream, {{lld::Gnu, &lld::elf::link}});
+    
+    if (!output.empty()) {
+        LOG_INFO("LinkerAgent: " + output);
+    }
+    if (!errors.empty()) {
+        LOG_ERROR("LinkerAgent: " + errors);
+    }
+    if (!result.canRunAgain) {
+        LOG_WARNING("LinkerAgent: lld cannot be re-entered in this process");
+    }
+    return result.retCode == 0;
+#else
+    return runProgram("ld.lld", args);
+#endif
+}
+
+bool LinkerAgent::runProgram(const std::string& name, const std::vector<std::string>& args) {
+    auto program = llvm::sys::findProgramByName(name);
+    if (!program) {
+        LOG_WARNING("LinkerAgent: " + name + " not found in PATH");
+        return false;
     }
     
-    cmd << "-o " << outputFile;
+    LOG_INFO("LinkerAgent: Running: " + *program + joinArgs(args));
     
-    LOG_INFO("LinkerAgent: Running: " + cmd.str());
-    int result = std::system(cmd.str().c_str());
+    // argv is passed straight to exec: no shell, so paths with spaces are safe
+    std::vector<llvm::StringRef> argv = {*program};
+    argv.insert(argv.end(), args.begin(), args.end());
     
+    std::string errorMessage;
+    int result = llvm::sys::ExecuteAndWait(*program, argv, std::nullopt, {}, 0, 0, &errorMessage);
     if (result != 0) {
+        LOG_ERROR("LinkerAgent: " + name + " failed" + (errorMessage.empty() ? "" : ": " + errorMessage));
+        return false;
+    }
+    return true;
+}
+
+bool LinkerAgent::linkELF(const std::vector<std::string>& objectFiles,
+                          const std::string& outputFile,
+                          const std::vector<std::string>& libraries,
+                          const std::string& symbolOrderingFile,
+                          bool shared) {
+    // Without a compiler driver the C runtime has to be found by hand
+    auto runtime = findCRuntime();
+    if (!runtime) {
+        LOG_WARNING("LinkerAgent: C runtime not found for this platform");
+        return false;
+    }
+    
+    // Shared objects use the PIC variants of GCC's startup files and no crt1.o
+    const char* crtBegin = shared ? "crtbeginS.o" : "crtbegin.o";
+    const char* crtEnd = shared ? "crtendS.o" : "crtend.o";
+    bool haveGccCrt = !runtime->gccDir.empty() && hasFile(runtime->gccDir, crtBegin) &&
+                      hasFile(runtime->gccDir, crtEnd);
+    
+    std::vector<std::string> args = {"-o", outputFile, "--eh-frame-hdr"};
+    if (shared) {
+        args.push_back("-shared");
+    } else {
+        args.push_back("-dynamic-linker");
+        args.push_back(runtime->dynamicLinker);
+    }
+    
+    if (!symbolOrderingFile.empty()) {
+        // Group hot functions so they share i-cache lines and TLB pages
+        args.push_back("--symbol-ordering-file=" + symbolOrderingFile);
+    }
+    
+    if (!shared) {
+        args.push_back(inDir(runtime->crtDir, "crt1.o"));
+    }
+    args.push_back(inDir(runtime->crtDir, "crti.o"));
+    if (haveGccCrt) {
+        args.push_back(inDir(runtime->gccDir, crtBegin));
+    }
+    if (!runtime->gccDir.empty()) {
+        args.push_back("-L" + runtime->gccDir);
+    }
+    args.push_back("-L" + runtime->crtDir);
+    
+    args.insert(args.end(), objectFiles.begin(), objectFiles.end());
+    
+    for (const auto& lib : libraries) {
+        args.push_back("-l" + lib);
+    }
+    
+    args.push_back("-lc");
+    if (!runtime->gccDir.empty()) {
+        args.push_back("-lgcc");
+    }
+    if (haveGccCrt) {
+        args.push_back(inDir(runtime->gccDir, crtEnd));
+    }
+    args.push_back(inDir(runtime->crtDir, "crtn.o"));
+    
+    return runLLD(args);
+}
+
+bool LinkerAgent::linkWithLLD(const std::vector<std::string>& objectFiles,
+                              const std::string& outputFile,
+                              const std::vector<std::string>& libraries,
+                              const std::string& symbolOrderingFile) {
+    LOG_INFO("LinkerAgent: Linking with lld");
+    
+    if (!linkELF(objectFiles, outputFile, libraries, symbolOrderingFile, false)) {
         LOG_ERROR("LinkerAgent: Linking failed");
         return false;
     }
@@ -33,34 +219,87 @@ bool LinkerAgent::linkWithLLD(const std::vector<std::string>& objectFiles,
     return true;
 }
 
+bool LinkerAgent::linkShared(const std::vector<std::string>& objectFiles,
+                             const std::string& outputFile,
+                             const std::vector<std::string>& libraries) {
+    LOG_INFO("LinkerAgent: Linking shared library: " + outputFile);
+    
+    if (!linkELF(objectFiles, outputFile, libraries, "", true)) {
+        LOG_WARNING("lld not available, trying system linker");
+        
+        #ifdef __APPLE__
+            const char* driver = "clang";
+        #else
+            const char* driver = "gcc";
+        #endif
+        
+        std::vector<std::string> args = {"-shared"};
+        args.insert(args.end(), objectFiles.begin(), objectFiles.end());
+        for (const auto& lib : libraries) {
+            args.push_back("-l" + lib);
+        }
+        args.push_back("-o");
+        args.push_back(outputFile);
+        
+        if (!runProgram(driver, args)) {
+            LOG_ERROR("LinkerAgent: Shared library link failed");
+            return false;
+        }
+    }
+    
+    LOG_INFO("LinkerAgent: Shared library linked successfully");
+    return true;
+}
+
+bool LinkerAgent::createStaticArchive(const std::vector<std::string>& objectFiles,
+                                      const std::string& outputFile) {
+    LOG_INFO("LinkerAgent: Creating static archive: " + outputFile);
+    
+    std::vector<llvm::NewArchiveMember> members;
+    for (const auto& obj : objectFiles) {
+        auto member = llvm::NewArchiveMember::getFile(obj, /*Deterministic=*/true);
+        if (!member) {
+            LOG_ERROR("LinkerAgent: Cannot read " + obj + ": " + llvm::toString(member.takeError()));
+            return false;
+        }
+        members.push_back(std::move(*member));
+    }
+    
+    llvm::Triple triple(llvm::sys::getProcessTriple());
+    auto kind = triple.isOSDarwin() ? llvm::object::Archive::K_DARWIN : llvm::object::Archive::K_GNU;
+    
+    // Written in-process, with a symbol table so linkers can pull members lazily
+    if (llvm::Error err = llvm::writeArchive(outputFile, members, llvm::SymtabWritingMode::NormalSymtab,
+                                             kind, /*Deterministic=*/true, /*Thin=*/false)) {
+        LOG_ERROR("LinkerAgent: Cannot write archive: " + llvm::toString(std::move(err)));
+        return false;
+    }
+    
+    LOG_INFO("LinkerAgent: Static archive created successfully");
+    return true;
+}
+
 bool LinkerAgent::linkWithSystemLinker(const std::vector<std::string>& objectFiles,
                                        const std::string& outputFile,
                                        const std::vector<std::string>& libraries) {
     LOG_INFO("LinkerAgent: Linking with system linker");
     
-    std::stringstream cmd;
     #ifdef __APPLE__
-        cmd << "clang ";
-    #elif __linux__
-        cmd << "gcc ";
+        const char* driver = "clang";
     #else
-        cmd << "gcc ";
+        const char* driver = "gcc";
     #endif
     
-    for (const auto& obj : objectFiles) {
-        cmd << obj << " ";
-    }
+    std::vector<std::string> args = objectFiles;
     
     for (const auto& lib : libraries) {
-        cmd << "-l" << lib << " ";
+        args.push_back("-l" + lib);
     }
     
-    cmd << "-o " << outputFile;
-    
-    LOG_INFO("LinkerAgent: Running: " + cmd.str());
-    int result = std::system(cmd.str().c_str());
+    args.push_back("-o");
+    args.push_back(outputFile);
     
-    if (result != 0) {
+    if (!runProgram(driver, args)) {
         LOG_ERROR("LinkerAgent: Linking failed");
         return false;
     }
@@ -69,3 +308,19 @@ bool LinkerAgent::linkWithSystemLinker(const std::vector<std::string>& objectFil
     return true;
 }
 
+
+bool LinkerAgent::linkRelocatable(const std::vector<std::string>& objectFiles,
+                                  const std::string& outputFile) {
+    LOG_INFO("LinkerAgent: Combining objects into relocatable: " + outputFile);
+    
+    std::vector<std::string> args = {"-r", "-o", outputFile};
+    args.insert(args.end(), objectFiles.begin(), objectFiles.end());
+    
+    if (!runLLD(args) && !runProgram("ld", args)) {
+        LOG_ERROR("LinkerAgent: Relocatable link failed");
+        return false;
+    }
+    
+    LOG_INFO("LinkerAgent: Relocatable link completed successfully");
+    return true;
+}
@@ -3,8 +3,10 @@
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Transforms/Utils.h>
 
-OptimizationAgent::OptimizationAgent() {
-    configureOptimizationLevel(2);
+OptimizationAgent::OptimizationAgent() : OptimizationAgent(2) {}
+
+OptimizationAgent::OptimizationAgent(int optLevel) {
+    configureOptimizationLevel(optLevel);
 }
 
 void OptimizationAgent::configureOptimizationLevel(int optLevel) {
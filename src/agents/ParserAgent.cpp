@@ -1,5 +1,9 @@
 #include "agents/ParserAgent.h"
 #include "utils/Logger.h"
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
@@ -29,3 +33,25 @@ std::string ParserAgent::readFile(const std::string& filename) {
     return buffer.str();
 }
 
+
+bool ParserAgent::isIRFile(const std::string& filename) {
+    llvm::StringRef ext = llvm::sys::path::extension(filename);
+    return ext == ".ll" || ext == ".bc";
+}
+
+std::unique_ptr<llvm::Module> ParserAgent::loadIRFile(const std::string& filename, llvm::LLVMContext& ctx) {
+    LOG_INFO("ParserAgent: Loading LLVM IR: " + filename);
+    
+    // parseIRFile accepts both textual IR and bitcode
+    llvm::SMDiagnostic error;
+    std::unique_ptr<llvm::Module> module = llvm::parseIRFile(filename, error, ctx);
+    if (!module) {
+        std::string message;
+        llvm::raw_string_ostream OS(message);
+        error.print("llvm_dsl_compiler", OS);
+        LOG_ERROR("ParserAgent: " + message);
+        return nullptr;
+    }
+    
+    return module;
+}
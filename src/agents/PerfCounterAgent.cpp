@@ -0,0 +1,187 @@
+#include "agents/PerfCounterAgent.h"
+#include "utils/Logger.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+struct EventSpec {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t readMisses(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+// Small groups so each fits the core's counters without multiplexing:
+// the first ratios against cycles, the second describes memory behaviour
+const std::vector<std::vector<EventSpec>> EventGroups = {
+    {{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+     {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+     {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}},
+    {{"L1D-read-misses", PERF_TYPE_HW_CACHE, readMisses(PERF_COUNT_HW_CACHE_L1D)},
+     {"LLC-read-misses", PERF_TYPE_HW_CACHE, readMisses(PERF_COUNT_HW_CACHE_LL)}},
+};
+
+int openEvent(const EventSpec& event, int groupFd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    // Members follow their leader, which starts disabled until start()
+    attr.disabled = groupFd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+#endif
+
+} // namespace
+
+PerfCounterAgent::~PerfCounterAgent() {
+#ifdef __linux__
+    for (auto& group : groups) {
+        for (auto& counter : group.counters) {
+            close(counter.fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounterAgent::open() {
+#ifdef __linux__
+    for (const auto& specs : EventGroups) {
+        Group group;
+        for (const auto& spec : specs) {
+            int leader = group.counters.empty() ? -1 : group.counters.front().fd;
+            int fd = openEvent(spec, leader);
+            if (fd < 0) {
+                if (errno == EACCES || errno == EPERM) {
+                    LOG_WARNING("PerfCounterAgent: perf_event_open not permitted "
+                                "(see /proc/sys/kernel/perf_event_paranoid)");
+                    if (!group.counters.empty()) {
+                        groups.push_back(std::move(group));
+                    }
+                    return !groups.empty();
+                }
+                LOG_WARNING(std::string("PerfCounterAgent: ") + spec.name + " is not supported: " +
+                            std::strerror(errno));
+                continue;
+            }
+            group.counters.push_back({spec.name, fd, 0});
+        }
+        if (!group.counters.empty()) {
+            groups.push_back(std::move(group));
+        }
+    }
+    return !groups.empty();
+#else
+    LOG_WARNING("PerfCounterAgent: Hardware counters need Linux perf_event_open");
+    return false;
+#endif
+}
+
+void PerfCounterAgent::start() {
+#ifdef __linux__
+    for (const auto& group : groups) {
+        int leader = group.counters.front().fd;
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+void PerfCounterAgent::stop() {
+#ifdef __linux__
+    for (const auto& group : groups) {
+        ioctl(group.counters.front().fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+    
+    // PERF_FORMAT_GROUP layout: nr, time enabled, time running, one value per member
+    for (auto& group : groups) {
+        std::vector<uint64_t> data(3 + group.counters.size());
+        ssize_t size = read(group.counters.front().fd, data.data(), data.size() * sizeof(uint64_t));
+        if (size < static_cast<ssize_t>(3 * sizeof(uint64_t)) || data[0] != group.counters.size()) {
+            group.enabled = group.running = 0;
+            continue;
+        }
+        group.enabled = data[1];
+        group.running = data[2];
+        for (size_t i = 0; i < group.counters.size(); i++) {
+            uint64_t value = data[3 + i];
+            if (group.running > 0 && group.running < group.enabled) {
+                value = static_cast<uint64_t>(static_cast<double>(value) * group.enabled / group.running);
+            }
+            group.counters[i].value = value;
+        }
+    }
+#endif
+}
+
+const PerfCounterAgent::Counter* PerfCounterAgent::find(const std::string& name) const {
+    for (const auto& group : groups) {
+        if (group.running == 0) continue;
+        for (const auto& counter : group.counters) {
+            if (counter.name == name) {
+                return &counter;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void PerfCounterAgent::report(const std::string& name, uint64_t calls) const {
+    calls = calls ? calls : 1;
+    auto precision = std::cout.precision();
+    std::cout << "\n=== Performance Counters: " << name << " (" << calls << " call"
+              << (calls == 1 ? "" : "s") << ") ===" << std::endl;
+    std::cout << std::fixed;
+    
+    for (const auto& group : groups) {
+        for (const auto& counter : group.counters) {
+            std::cout << std::left << std::setw(18) << counter.name << std::right;
+            if (group.running == 0) {
+                std::cout << std::setw(16) << "<not counted>" << std::endl;
+                continue;
+            }
+            std::cout << std::setw(16) << counter.value << std::setprecision(1) << std::setw(14)
+                      << static_cast<double>(counter.value) / calls << " / call" << std::endl;
+        }
+        if (group.running > 0 && group.running < group.enabled) {
+            std::cout << "  (scaled: group counted " << std::setprecision(0)
+                      << 100.0 * group.running / group.enabled << "% of the time)" << std::endl;
+        }
+    }
+    
+    const Counter* cycles = find("cycles");
+    const Counter* instructions = find("instructions");
+    if (cycles && instructions && cycles->value > 0) {
+        std::cout << std::left << std::setw(18) << "IPC" << std::right << std::setw(16) << std::setprecision(2)
+                  << static_cast<double>(instructions->value) / cycles->value << std::endl;
+    }
+    if (instructions && instructions->value > 0) {
+        for (const char* misses : {"L1D-read-misses", "LLC-read-misses"}) {
+            if (const Counter* counter = find(misses)) {
+                std::cout << std::left << std::setw(18) << (std::string(misses, 3) + " MPKI") << std::right
+                          << std::setw(16) << std::setprecision(2)
+                          << 1000.0 * counter->value / instructions->value << std::endl;
+            }
+        }
+    }
+    
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout.precision(precision);
+}
@@ -0,0 +1,236 @@
+#include "agents/ProfileAgent.h"
+#include "utils/Logger.h"
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/ProfileSummary.h>
+#include <llvm/ProfileData/ProfileCommon.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Transforms/Utils/ModuleUtils.h>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+struct CounterRecord {
+    std::string name;
+    uint64_t hash;
+    llvm::GlobalVariable* counters;
+    size_t numCounters;
+};
+
+void addToCounter(llvm::IRBuilder<>& builder, llvm::GlobalVariable* counters,
+                  size_t index, llvm::Value* amount) {
+    llvm::Value* slot = builder.CreateConstInBoundsGEP2_64(
+        counters->getValueType(), counters, 0, index, "prof.slot");
+    llvm::Value* current = builder.CreateLoad(builder.getInt64Ty(), slot, "prof.count");
+    builder.CreateStore(builder.CreateAdd(current, amount, "prof.inc"), slot);
+}
+
+} // namespace
+
+uint64_t ProfileAgent::computeFunctionHash(llvm::Function& func) {
+    // Structural hash of the CFG shape, used to reject stale profiles
+    std::string shape;
+    for (auto& bb : func) {
+        shape += std::to_string(bb.size()) + ":";
+        for (auto& inst : bb) {
+            shape += std::to_string(inst.getOpcode()) + ",";
+        }
+        shape += ";";
+    }
+    return llvm::MD5::hash(llvm::arrayRefFromStringRef(shape)).low();
+}
+
+std::vector<llvm::BranchInst*> ProfileAgent::collectBranches(llvm::Function& func) {
+    std::vector<llvm::BranchInst*> branches;
+    for (auto& bb : func) {
+        auto* br = llvm::dyn_cast_or_null<llvm::BranchInst>(bb.getTerminator());
+        if (br && br->isConditional()) {
+            branches.push_back(br);
+        }
+    }
+    return branches;
+}
+
+bool ProfileAgent::instrument(llvm::Module* module, const std::string& profileFile) {
+    LOG_INFO("ProfileAgent: Instrumenting module for profile generation");
+
+    llvm::LLVMContext& ctx = module->getContext();
+    llvm::IRBuilder<> builder(ctx);
+    std::vector<CounterRecord> records;
+
+    for (auto& func : *module) {
+        if (func.isDeclaration()) continue;
+
+        uint64_t hash = computeFunctionHash(func);
+        auto branches = collectBranches(func);
+        size_t numCounters = 1 + 2 * branches.size();
+
+        auto* arrayTy = llvm::ArrayType::get(builder.getInt64Ty(), numCounters);
+        auto* counters = new llvm::GlobalVariable(
+            *module, arrayTy, false, llvm::GlobalValue::InternalLinkage,
+            llvm::ConstantAggregateZero::get(arrayTy), "__dsl_prof_" + func.getName());
+
+        builder.SetInsertPoint(&*func.getEntryBlock().getFirstInsertionPt());
+        addToCounter(builder, counters, 0, builder.getInt64(1));
+
+        for (size_t i = 0; i < branches.size(); i++) {
+            builder.SetInsertPoint(branches[i]);
+            llvm::Value* taken = builder.CreateZExt(
+                branches[i]->getCondition(), builder.getInt64Ty(), "prof.taken");
+            addToCounter(builder, counters, 1 + 2 * i, taken);
+            addToCounter(builder, counters, 2 + 2 * i,
+                         builder.CreateSub(builder.getInt64(1), taken, "prof.nottaken"));
+        }
+
+        records.push_back({func.getName().str(), hash, counters, numCounters});
+    }
+
+    // void __dsl_prof_dump(): writes every counter array to profileFile
+    auto* dumpFunc = llvm::Function::Create(
+        llvm::FunctionType::get(builder.getVoidTy(), false),
+        llvm::Function::ExternalLinkage, DumpFunctionName, *module);
+    auto* entry = llvm::BasicBlock::Create(ctx, "entry", dumpFunc);
+    auto* write = llvm::BasicBlock::Create(ctx, "write", dumpFunc);
+    auto* done = llvm::BasicBlock::Create(ctx, "done", dumpFunc);
+
+    llvm::Type* ptrTy = builder.getPtrTy();
+    auto fopenFunc = module->getOrInsertFunction(
+        "fopen", llvm::FunctionType::get(ptrTy, {ptrTy, ptrTy}, false));
+    auto fprintfFunc = module->getOrInsertFunction(
+        "fprintf", llvm::FunctionType::get(builder.getInt32Ty(), {ptrTy, ptrTy}, true));
+    auto fcloseFunc = module->getOrInsertFunction(
+        "fclose", llvm::FunctionType::get(builder.getInt32Ty(), {ptrTy}, false));
+
+    builder.SetInsertPoint(entry);
+    llvm::Value* file = builder.CreateCall(
+        fopenFunc, {builder.CreateGlobalString(profileFile, "prof.path"),
+                    builder.CreateGlobalString("w", "prof.mode")}, "prof.file");
+    builder.CreateCondBr(builder.CreateIsNull(file), done, write);
+
+    builder.SetInsertPoint(write);
+    builder.CreateCall(fprintfFunc, {file, builder.CreateGlobalString("# DSL profile v1\n", "prof.header")});
+    llvm::Value* recordFmt = builder.CreateGlobalString("%s %llu %llu\n", "prof.recfmt");
+    llvm::Value* counterFmt = builder.CreateGlobalString("%llu\n", "prof.cntfmt");
+    for (const auto& record : records) {
+        builder.CreateCall(fprintfFunc, {file, recordFmt,
+                                         builder.CreateGlobalString(record.name, "prof.name"),
+                                         builder.getInt64(record.hash),
+                                         builder.getInt64(record.numCounters)});
+        for (size_t i = 0; i < record.numCounters; i++) {
+            llvm::Value* slot = builder.CreateConstInBoundsGEP2_64(
+                record.counters->getValueType(), record.counters, 0, i);
+            builder.CreateCall(fprintfFunc, {file, counterFmt,
+                                             builder.CreateLoad(builder.getInt64Ty(), slot)});
+        }
+    }
+    builder.CreateCall(fcloseFunc, {file});
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(done);
+    builder.CreateRetVoid();
+
+    // Executables flush the profile at exit; the JIT driver calls the dump directly
+    llvm::appendToGlobalDtors(*module, dumpFunc, 0);
+
+    LOG_INFO("ProfileAgent: Instrumented " + std::to_string(records.size()) +
+             " function(s), profile will be written to " + profileFile);
+    return true;
+}
+
+bool ProfileAgent::readProfile(const std::string& filename) {
+    LOG_INFO("ProfileAgent: Reading profile: " + filename);
+
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        LOG_ERROR("ProfileAgent: Cannot open profile: " + filename);
+        return false;
+    }
+
+    profiles.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream header(line);
+        std::string name;
+        FunctionProfile profile;
+        size_t numCounters = 0;
+        if (!(header >> name >> profile.hash >> numCounters)) {
+            LOG_ERROR("ProfileAgent: Malformed profile record: " + line);
+            return false;
+        }
+
+        for (size_t i = 0; i < numCounters; i++) {
+            uint64_t count = 0;
+            if (!(file >> count)) {
+                LOG_ERROR("ProfileAgent: Truncated profile record for: " + name);
+                return false;
+            }
+            profile.counters.push_back(count);
+        }
+        std::getline(file, line);
+
+        profiles[name] = std::move(profile);
+    }
+
+    LOG_INFO("ProfileAgent: Loaded profile for " + std::to_string(profiles.size()) + " function(s)");
+    return true;
+}
+
+bool ProfileAgent::applyProfile(llvm::Module* module) {
+    LOG_INFO("ProfileAgent: Applying profile to module");
+
+    llvm::LLVMContext& ctx = module->getContext();
+    llvm::MDBuilder mdBuilder(ctx);
+    llvm::InstrProfSummaryBuilder summaryBuilder(llvm::ProfileSummaryBuilder::DefaultCutoffs.vec());
+    size_t applied = 0;
+
+    for (auto& func : *module) {
+        if (func.isDeclaration()) continue;
+
+        auto it = profiles.find(func.getName().str());
+        if (it == profiles.end()) continue;
+
+        const FunctionProfile& profile = it->second;
+        auto branches = collectBranches(func);
+        if (profile.hash != computeFunctionHash(func) ||
+            profile.counters.size() != 1 + 2 * branches.size()) {
+            LOG_WARNING("ProfileAgent: Stale profile ignored for: " + func.getName().str());
+            continue;
+        }
+
+        func.setEntryCount(profile.counters[0]);
+        summaryBuilder.addEntryCount(profile.counters[0]);
+
+        for (size_t i = 0; i < branches.size(); i++) {
+            uint64_t taken = profile.counters[1 + 2 * i];
+            uint64_t notTaken = profile.counters[2 + 2 * i];
+            summaryBuilder.addInternalCount(taken);
+            summaryBuilder.addInternalCount(notTaken);
+
+            // Scale into 32-bit weights the same way clang does
+            uint64_t scale = std::max(taken, notTaken) / std::numeric_limits<uint32_t>::max() + 1;
+            branches[i]->setMetadata(llvm::LLVMContext::MD_prof,
+                                     mdBuilder.createBranchWeights(
+                                         static_cast<uint32_t>(taken / scale + 1),
+                                         static_cast<uint32_t>(notTaken / scale + 1)));
+        }
+        applied++;
+    }
+
+    if (applied == 0) {
+        LOG_WARNING("ProfileAgent: Profile did not match any function");
+        return false;
+    }
+
+    module->setProfileSummary(summaryBuilder.getSummary()->getMD(ctx),
+                              llvm::ProfileSummary::PSK_Instr);
+
+    LOG_INFO("ProfileAgent: Profile applied to " + std::to_string(applied) + " function(s)");
+    return true;
+}
@@ -0,0 +1,420 @@
+#include "agents/ReplAgent.h"
+#include "agents/ParserAgent.h"
+#include "agents/ASTAgent.h"
+#include "agents/IRGenerationAgent.h"
+#include "agents/OptimizationAgent.h"
+#include "agents/VerificationAgent.h"
+#include "agents/StdlibAgent.h"
+#include "agents/InvocationAgent.h"
+#include "utils/Logger.h"
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <iostream>
+#include <optional>
+#include <sstream>
+
+namespace {
+
+const char* typeName(ast::Type type) {
+    switch (type.kind) {
+        case ast::Type::I32: return "i32";
+        case ast::Type::I64: return "i64";
+        case ast::Type::F32: return "f32";
+        case ast::Type::F64: return "f64";
+        case ast::Type::Bool: return "bool";
+        case ast::Type::Void: return "void";
+    }
+    return "void";
+}
+
+void printHelp() {
+    std::cout << "Commands:\n"
+              << "  load <file>...        Compile .dsl/.ll/.bc files into the session (replaces earlier versions)\n"
+              << "  reload [<file>...]    Load the files again from disk (all loaded files by default)\n"
+              << "  unload <file>         Remove a file's code from the session\n"
+              << "  call <fn> [args...]   Call a function and print its result\n"
+              << "  list                  Show the callable functions\n"
+              << "  quit                  End the session" << std::endl;
+}
+
+} // namespace
+
+ReplAgent::ReplAgent(JITAgent& jit, int optLevel)
+    : jit(jit), optLevel(optLevel), stdlibPrototypes(StdlibAgent::getPrototypes()) {
+}
+
+llvm::orc::JITDylib* ReplAgent::getDylib(const std::string& filename) {
+    auto it = dylibs.find(filename);
+    if (it != dylibs.end()) {
+        return it->second;
+    }
+    
+    llvm::orc::JITDylib* dylib = jit.createDylib(filename);
+    if (!dylib) {
+        return nullptr;
+    }
+    
+    // Every file can call every other one, whichever was loaded first
+    for (const auto& [name, other] : dylibs) {
+        dylib->addToLinkOrder(*other);
+        other->addToLinkOrder(*dylib);
+    }
+    dylibs[filename] = dylib;
+    return dylib;
+}
+
+bool ReplAgent::compile(Unit& unit, llvm::orc::ThreadSafeModule& compiled) {
+    // Each unit owns its context, so removing it frees all of its IR
+    auto context = std::make_unique<llvm::LLVMContext>();
+    std::unique_ptr<llvm::Module> module;
+    auto program = std::make_unique<ast::Program>();
+    
+    if (ParserAgent::isIRFile(unit.filename)) {
+        llvm::SMDiagnostic error;
+        module = llvm::parseIR(llvm::MemoryBufferRef(unit.source, unit.filename), error, *context);
+        if (!module) {
+            std::string message;
+            llvm::raw_string_ostream OS(message);
+            error.print("llvm_dsl_compiler", OS);
+            LOG_ERROR("ReplAgent: " + message);
+            return false;
+        }
+        for (auto& prototype : IRGenerationAgent::importPrototypes(*module)) {
+            program->addFunction(std::move(prototype));
+        }
+    } else {
+        try {
+            program = ParserAgent(unit.source).parse();
+            ASTAgent::validateAST(program.get());
+        } catch (const std::exception& e) {
+            LOG_ERROR("ReplAgent: Parse error in " + unit.filename + ": " + std::string(e.what()));
+            return false;
+        }
+    
+        // Functions of other units come before the standard library, which they shadow
+        std::unordered_set<std::string> declared;
+        for (const auto& func : program->functions) {
+            declared.insert(func->name);
+        }
+        IRGenerationAgent irAgent(*context, unit.filename);
+        for (const auto& [filename, other] : units) {
+            if (filename == unit.filename) continue;
+            for (const auto& func : other.program->functions) {
+                if (declared.insert(func->name).second) {
+                    irAgent.declareFunction(func.get());
+                }
+            }
+        }
+        for (const auto& prototype : stdlibPrototypes) {
+            if (declared.insert(prototype->name).second) {
+                irAgent.declareFunction(prototype.get());
+            }
+        }
+    
+        if (!irAgent.generate(program.get())) {
+            LOG_ERROR("ReplAgent: IR generation failed for " + unit.filename);
+            return false;
+        }
+        module = irAgent.takeModule();
+    }
+    
+    if (module->getTargetTriple().str().empty()) {
+        moduleSetup.setupModule(module.get());
+    }
+    if (!StdlibAgent::linkInto(module.get())) {
+        return false;
+    }
+    InvocationAgent::createTrampolines(module.get());
+    
+    if (optLevel > 0) {
+        OptimizationAgent optAgent(optLevel);
+        optAgent.optimize(module.get());
+    }
+    if (!VerificationAgent::verify(module.get(), true)) {
+        return false;
+    }
+    
+    unit.imports.clear();
+    for (const auto& func : *module) {
+        if (func.isDeclaration() && !func.isIntrinsic()) {
+            unit.imports.insert(func.getName().str());
+        }
+    }
+    unit.program = std::move(program);
+    compiled = llvm::orc::ThreadSafeModule(std::move(module), std::move(context));
+    return true;
+}
+
+bool ReplAgent::add(Unit& unit, llvm::orc::ThreadSafeModule compiled) {
+    llvm::orc::JITDylib* dylib = getDylib(unit.filename);
+    if (!dylib) {
+        return false;
+    }
+    unit.tracker = dylib->createResourceTracker();
+    return jit.addModule(std::move(compiled), unit.tracker);
+}
+
+std::vector<std::string> ReplAgent::findDependents(const std::unordered_set<std::string>& names,
+                                                   const std::string& exclude) const {
+    std::vector<std::string> dependents;
+    std::unordered_set<std::string> targets = names;
+    std::unordered_set<std::string> visited = {exclude};
+    
+    // Callers of a dependent hold its old addresses too, so follow the chain
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& [filename, unit] : units) {
+            if (visited.count(filename)) continue;
+            bool calls = false;
+            for (const auto& name : unit.imports) {
+                if (targets.count(name)) {
+                    calls = true;
+                    break;
+                }
+            }
+            if (!calls) continue;
+    
+            visited.insert(filename);
+            dependents.push_back(filename);
+            for (const auto& func : unit.program->functions) {
+                targets.insert(func->name);
+            }
+            changed = true;
+        }
+    }
+    
+    return dependents;
+}
+
+const ReplAgent::Unit* ReplAgent::findDefinition(const std::string& function, ast::Function*& func) const {
+    for (const auto& [filename, unit] : units) {
+        for (const auto& candidate : unit.program->functions) {
+            if (candidate->name == function) {
+                func = candidate.get();
+                return &unit;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool ReplAgent::load(const std::string& filename) {
+    LOG_INFO("ReplAgent: Loading " + filename);
+    
+    Unit unit;
+    unit.filename = filename;
+    try {
+        unit.source = ParserAgent::readFile(filename);
+    } catch (const std::exception& e) {
+        LOG_ERROR("ReplAgent: " + std::string(e.what()));
+        return false;
+    }
+    
+    // A failed compile or add leaves the previous version running
+    llvm::orc::ThreadSafeModule compiled;
+    if (!compile(unit, compiled)) {
+        return false;
+    }
+    
+    for (const auto& func : unit.program->functions) {
+        ast::Function* existing = nullptr;
+        const Unit* owner = findDefinition(func->name, existing);
+        if (owner && owner->filename != filename) {
+            LOG_ERROR("ReplAgent: " + func->name + " is already defined in " + owner->filename);
+            return false;
+        }
+    }
+    
+    // Callers of the old or the new definitions must bind to the new code
+    std::unordered_set<std::string> names;
+    for (const auto& func : unit.program->functions) {
+        names.insert(func->name);
+    }
+    // A JITDylib cannot define a symbol twice, so the old version leaves before
+    // the new one is added and is rebuilt from its source if the add fails
+    std::optional<Unit> replaced;
+    auto previous = units.find(filename);
+    if (previous != units.end()) {
+        for (const auto& func : previous->second.program->functions) {
+            names.insert(func->name);
+        }
+        if (!jit.removeModule(previous->second.tracker)) {
+            return false;
+        }
+        replaced = std::move(previous->second);
+        units.erase(previous);
+    }
+    
+    Unit& loaded = units.emplace(filename, std::move(unit)).first->second;
+    if (!add(loaded, std::move(compiled))) {
+        units.erase(filename);
+        if (replaced) {
+            Unit& restored = units.emplace(filename, std::move(*replaced)).first->second;
+            llvm::orc::ThreadSafeModule recompiled;
+            if (!compile(restored, recompiled) || !add(restored, std::move(recompiled))) {
+                LOG_ERROR("ReplAgent: The previous version of " + filename + " could not be restored");
+                units.erase(filename);
+            }
+        }
+        return false;
+    }
+    
+    for (const auto& dependent : findDependents(names, filename)) {
+        Unit& caller = units.at(dependent);
+        LOG_INFO("ReplAgent: Re-adding " + dependent);
+        jit.removeModule(caller.tracker);
+    
+        llvm::orc::ThreadSafeModule recompiled;
+        if (!compile(caller, recompiled) || !add(caller, std::move(recompiled))) {
+            LOG_ERROR("ReplAgent: " + dependent + " no longer compiles against " + filename + " and was unloaded");
+            units.erase(dependent);
+        }
+    }
+    
+    return true;
+}
+
+bool ReplAgent::unload(const std::string& filename) {
+    auto it = units.find(filename);
+    if (it == units.end()) {
+        LOG_ERROR("ReplAgent: " + filename + " is not loaded");
+        return false;
+    }
+    
+    std::unordered_set<std::string> names;
+    for (const auto& func : it->second.program->functions) {
+        names.insert(func->name);
+    }
+    auto dependents = findDependents(names, filename);
+    if (!dependents.empty()) {
+        LOG_ERROR("ReplAgent: Cannot unload " + filename + ", it is called from " + dependents.front());
+        return false;
+    }
+    
+    if (!jit.removeModule(it->second.tracker)) {
+        return false;
+    }
+    units.erase(it);
+    return true;
+}
+
+bool ReplAgent::call(const std::string& function, const std::vector<std::string>& args, std::string& result) {
+    ast::Function* func = nullptr;
+    const Unit* unit = findDefinition(function, func);
+    if (!unit) {
+        LOG_ERROR("ReplAgent: Unknown function " + function);
+        return false;
+    }
+    
+    if (args.size() != func->params.size()) {
+        LOG_ERROR("ReplAgent: " + function + " expects " + std::to_string(func->params.size()) + " argument(s)");
+        return false;
+    }
+    
+    std::vector<InvocationSlot> slots(args.size());
+    for (size_t i = 0; i < args.size(); i++) {
+        if (!InvocationAgent::parseValue(args[i], func->params[i].second, slots[i])) {
+            LOG_ERROR("ReplAgent: Invalid " + std::string(typeName(func->params[i].second)) + " for " +
+                      func->params[i].first + ": " + args[i]);
+            return false;
+        }
+    }
+    
+    auto entry = reinterpret_cast<EntryTrampoline>(
+        jit.getFunctionAddress(*dylibs.at(unit->filename), InvocationAgent::trampolineName(function)));
+    if (!entry) {
+        return false;
+    }
+    
+    InvocationSlot value = {};
+    entry(slots.data(), &value);
+    result = InvocationAgent::formatValue(value, func->returnType);
+    return true;
+}
+
+void ReplAgent::list() const {
+    for (const auto& [filename, unit] : units) {
+        std::cout << filename << ":" << std::endl;
+        for (const auto& func : unit.program->functions) {
+            std::cout << "  fn " << func->name << "(";
+            for (size_t i = 0; i < func->params.size(); i++) {
+                if (i > 0) std::cout << ", ";
+                std::cout << func->params[i].first << ": " << typeName(func->params[i].second);
+            }
+            std::cout << ") -> " << typeName(func->returnType) << std::endl;
+        }
+    }
+}
+
+bool ReplAgent::execute(const std::string& line) {
+    std::istringstream input(line);
+    std::string command;
+    if (!(input >> command) || command[0] == '#') {
+        return true;
+    }
+    
+    std::vector<std::string> args;
+    std::string arg;
+    while (input >> arg) {
+        args.push_back(arg);
+    }
+    
+    if (command == "quit" || command == "exit") {
+        return false;
+    } else if (command == "help") {
+        printHelp();
+    } else if (command == "load" || command == "reload") {
+        if (args.empty() && command == "reload") {
+            for (const auto& [filename, unit] : units) {
+                args.push_back(filename);
+            }
+        }
+        if (args.empty()) {
+            LOG_ERROR("ReplAgent: load needs a file");
+        }
+        for (const auto& filename : args) {
+            load(filename);
+        }
+    } else if (command == "unload") {
+        if (args.size() != 1) {
+            LOG_ERROR("ReplAgent: unload needs one file");
+        } else {
+            unload(args.front());
+        }
+    } else if (command == "call") {
+        if (args.empty()) {
+            LOG_ERROR("ReplAgent: call needs a function name");
+        } else {
+            std::string function = args.front();
+            args.erase(args.begin());
+            std::string result;
+            if (call(function, args, result) && !result.empty()) {
+                std::cout << result << std::endl;
+            }
+        }
+    } else if (command == "list") {
+        list();
+    } else {
+        LOG_ERROR("ReplAgent: Unknown command '" + command + "' (try help)");
+    }
+    
+    return true;
+}
+
+void ReplAgent::run(std::istream& input) {
+    // Scripts piped on stdin get no prompt
+    bool interactive = llvm::sys::Process::StandardInIsUserInput();
+    std::string line;
+    while (true) {
+        if (interactive) {
+            std::cout << "dsl> " << std::flush;
+        }
+        if (!std::getline(input, line) || !execute(line)) {
+            break;
+        }
+    }
+}
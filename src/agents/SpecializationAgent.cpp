@@ -0,0 +1,219 @@
+#include "agents/SpecializationAgent.h"
+#include "agents/IRGenerationAgent.h"
+#include "agents/OptimizationAgent.h"
+#include "agents/VerificationAgent.h"
+#include "utils/Logger.h"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/Transforms/Utils/ValueMapper.h>
+
+namespace {
+
+llvm::Constant* toConstant(const InvocationSlot& slot, ast::Type type, llvm::Type* llvmType) {
+    switch (type.kind) {
+        case ast::Type::Bool:
+            return llvm::ConstantInt::get(llvmType, slot.b);
+        case ast::Type::I32:
+            return llvm::ConstantInt::getSigned(llvmType, slot.i32);
+        case ast::Type::I64:
+            return llvm::ConstantInt::getSigned(llvmType, slot.i64);
+        case ast::Type::F32:
+            return llvm::ConstantFP::get(llvmType, slot.f32);
+        case ast::Type::F64:
+            return llvm::ConstantFP::get(llvmType, slot.f64);
+        case ast::Type::Void:
+            break;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+SpecializationAgent::SpecializationAgent(JITAgent& jit, int optLevel)
+    : jit(jit), optLevel(optLevel) {}
+
+bool SpecializationAgent::setModule(const llvm::Module& module) {
+    std::lock_guard<std::mutex> lock(mutex);
+    bitcode.clear();
+    llvm::raw_string_ostream OS(bitcode);
+    llvm::WriteBitcodeToFile(module, OS);
+    OS.flush();
+    return !bitcode.empty();
+}
+
+bool SpecializationAgent::parseRequest(const std::string& text, std::string& function,
+                                       std::vector<std::pair<std::string, std::string>>& constants) {
+    auto [name, list] = llvm::StringRef(text).split(':');
+    if (name.empty() || list.empty()) {
+        return false;
+    }
+    
+    function = name.str();
+    constants.clear();
+    llvm::SmallVector<llvm::StringRef, 4> items;
+    list.split(items, ',');
+    for (llvm::StringRef item : items) {
+        auto [param, value] = item.split('=');
+        param = param.trim();
+        value = value.trim();
+        if (param.empty() || value.empty()) {
+            return false;
+        }
+        constants.push_back({param.str(), value.str()});
+    }
+    return true;
+}
+
+const SpecializationAgent::Specialization* SpecializationAgent::specialize(
+    const std::string& function, const std::vector<std::pair<std::string, std::string>>& constants) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (bitcode.empty()) {
+        LOG_ERROR("SpecializationAgent: No program module");
+        return nullptr;
+    }
+    
+    auto ctx = std::make_unique<llvm::LLVMContext>();
+    auto moduleOrError = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "specialize"), *ctx);
+    if (!moduleOrError) {
+        llvm::logAllUnhandledErrors(moduleOrError.takeError(), llvm::errs(), "Specialization Error: ");
+        return nullptr;
+    }
+    std::unique_ptr<llvm::Module> module = std::move(*moduleOrError);
+    
+    llvm::Function* target = module->getFunction(function);
+    std::unique_ptr<ast::Function> prototype;
+    for (auto& candidate : IRGenerationAgent::importPrototypes(*module)) {
+        if (candidate->name == function) {
+            prototype = std::move(candidate);
+        }
+    }
+    if (!target || !prototype) {
+        LOG_ERROR("SpecializationAgent: Cannot specialize " + function);
+        return nullptr;
+    }
+    
+    // Resolve every constant to a parameter; the key lists values in parameter
+    // order as they were parsed, so "n=8" and "n=0x8" share one entry
+    size_t arity = target->arg_size();
+    std::vector<llvm::Constant*> fixed(arity, nullptr);
+    std::vector<std::string> fixedText(arity);
+    for (const auto& [param, text] : constants) {
+        size_t index = arity;
+        for (const auto& arg : target->args()) {
+            if (arg.getName() == param) {
+                index = arg.getArgNo();
+            }
+        }
+        unsigned position;
+        if (index == arity && !llvm::StringRef(param).getAsInteger(10, position)) {
+            index = position;
+        }
+        if (index >= arity) {
+            LOG_ERROR("SpecializationAgent: " + function + " has no parameter " + param);
+            return nullptr;
+        }
+    
+        ast::Type type = prototype->params[index].second;
+        InvocationSlot slot = {};
+        if (!InvocationAgent::parseValue(text, type, slot)) {
+            LOG_ERROR("SpecializationAgent: Invalid value for " + param + ": " + text);
+            return nullptr;
+        }
+        fixed[index] = toConstant(slot, type, target->getArg(index)->getType());
+        fixedText[index] = InvocationAgent::formatValue(slot, type);
+    }
+    
+    std::string key = function;
+    for (size_t i = 0; i < arity; i++) {
+        if (fixed[i]) {
+            key += "," + std::to_string(i) + "=" + fixedText[i];
+        }
+    }
+    auto cached = cache.find(key);
+    if (cached != cache.end()) {
+        return cached->second.get();
+    }
+    
+    // Copy the body with the fixed parameters replaced by their constants
+    auto specialization = std::make_unique<Specialization>();
+    specialization->name = "__dsl_spec." + function + "." + std::to_string(cache.size());
+    std::vector<llvm::Type*> paramTypes;
+    std::vector<std::pair<std::string, ast::Type>> remaining;
+    for (const auto& arg : target->args()) {
+        if (!fixed[arg.getArgNo()]) {
+            paramTypes.push_back(arg.getType());
+            remaining.push_back(prototype->params[arg.getArgNo()]);
+        }
+    }
+    auto* type = llvm::FunctionType::get(target->getReturnType(), paramTypes, false);
+    auto* clone = llvm::Function::Create(type, llvm::Function::ExternalLinkage, specialization->name, module.get());
+    
+    llvm::ValueToValueMapTy values;
+    auto next = clone->arg_begin();
+    for (auto& arg : target->args()) {
+        if (fixed[arg.getArgNo()]) {
+            values[&arg] = fixed[arg.getArgNo()];
+        } else {
+            next->setName(arg.getName());
+            values[&arg] = &*next++;
+        }
+    }
+    llvm::SmallVector<llvm::ReturnInst*, 4> returns;
+    llvm::CloneFunctionInto(clone, target, values, llvm::CloneFunctionChangeType::LocalChangesOnly, returns);
+    
+    // Only the copy and its trampoline are emitted. Other definitions stay
+    // visible to the inliner but resolve to the code already in the JIT
+    for (auto& func : *module) {
+        if (&func == clone || func.isDeclaration() || func.hasLocalLinkage()) continue;
+        if (func.hasLinkOnceLinkage() || func.hasWeakLinkage()) continue;
+        func.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+        func.setComdat(nullptr);
+    }
+    // Constructor lists already ran with the program
+    std::vector<llvm::GlobalVariable*> appending;
+    for (auto& global : module->globals()) {
+        if (global.hasAppendingLinkage()) {
+            appending.push_back(&global);
+            continue;
+        }
+        if (global.isDeclaration() || global.hasLocalLinkage()) continue;
+        global.setInitializer(nullptr);
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        global.setComdat(nullptr);
+    }
+    for (llvm::GlobalVariable* global : appending) {
+        global->eraseFromParent();
+    }
+    if (!InvocationAgent::createTrampoline(clone)) {
+        LOG_ERROR("SpecializationAgent: Cannot call " + function + ": unsupported signature");
+        return nullptr;
+    }
+    
+    // Constant propagation, unrolling and vectorization now see the fixed values
+    if (optLevel > 0) {
+        OptimizationAgent optAgent(optLevel);
+        optAgent.optimize(module.get());
+    }
+    if (!VerificationAgent::verify(module.get(), true)) {
+        return nullptr;
+    }
+    
+    if (!jit.addModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(ctx)))) {
+        return nullptr;
+    }
+    specialization->address = jit.getFunctionAddress(specialization->name);
+    specialization->entry = reinterpret_cast<EntryTrampoline>(
+        jit.getFunctionAddress(InvocationAgent::trampolineName(specialization->name)));
+    if (!specialization->address || !specialization->entry) {
+        return nullptr;
+    }
+    specialization->signature = std::make_unique<ast::Function>(
+        function, prototype->returnType, std::move(remaining), std::vector<std::unique_ptr<ast::Stmt>>());
+    
+    LOG_INFO("SpecializationAgent: " + key + " compiled as " + specialization->name);
+    return cache.emplace(key, std::move(specialization)).first->second.get();
+}
@@ -0,0 +1,87 @@
+#include "agents/StdlibAgent.h"
+#include "agents/IRGenerationAgent.h"
+#include "utils/Logger.h"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+// Generated at build time from stdlib/stdlib.ll (see CMakeLists.txt)
+extern const unsigned char DSLStdlibBitcode[];
+extern const size_t DSLStdlibBitcodeSize;
+
+namespace {
+
+llvm::MemoryBufferRef bitcodeBuffer() {
+    return llvm::MemoryBufferRef(
+        llvm::StringRef(reinterpret_cast<const char*>(DSLStdlibBitcode), DSLStdlibBitcodeSize),
+        "dsl_stdlib");
+}
+
+std::unique_ptr<llvm::Module> loadLazy(llvm::LLVMContext& ctx) {
+    // Function bodies stay in the bitcode until the linker asks for them
+    auto library = llvm::getLazyBitcodeModule(bitcodeBuffer(), ctx);
+    if (!library) {
+        LOG_ERROR("StdlibAgent: Cannot load standard library");
+        llvm::logAllUnhandledErrors(library.takeError(), llvm::errs(), "Stdlib Error: ");
+        return nullptr;
+    }
+    return std::move(*library);
+}
+
+} // namespace
+
+std::vector<std::unique_ptr<ast::Function>> StdlibAgent::getPrototypes() {
+    llvm::LLVMContext ctx;
+    auto library = loadLazy(ctx);
+    if (!library) {
+        return {};
+    }
+    return IRGenerationAgent::importPrototypes(*library);
+}
+
+bool StdlibAgent::linkInto(llvm::Module* module) {
+    auto library = loadLazy(module->getContext());
+    if (!library) {
+        return false;
+    }
+    
+    // Prototypes are declared up front in every module; drop the unused ones so
+    // LinkOnlyNeeded does not pull in their bodies
+    size_t needed = 0;
+    for (auto& libFunc : *library) {
+        if (libFunc.isDeclaration()) continue;
+        llvm::Function* func = module->getFunction(libFunc.getName());
+        if (!func || !func->isDeclaration()) continue;
+        if (func->use_empty()) {
+            func->eraseFromParent();
+        } else {
+            needed++;
+        }
+    }
+    
+    if (needed == 0) {
+        return true;
+    }
+    
+    // The library is target independent; adopt the module's target to avoid
+    // mismatch warnings from the linker
+    library->setDataLayout(module->getDataLayout());
+    library->setTargetTriple(module->getTargetTriple());
+    
+    if (llvm::Linker::linkModules(*module, std::move(library), llvm::Linker::LinkOnlyNeeded)) {
+        LOG_ERROR("StdlibAgent: Failed to link standard library into " + module->getModuleIdentifier());
+        return false;
+    }
+    
+    LOG_INFO("StdlibAgent: Linked " + std::to_string(needed) + " library function(s) into " +
+             module->getModuleIdentifier());
+    return true;
+}
+
+std::string StdlibAgent::getContentHash() {
+    llvm::MD5::MD5Result hash = llvm::MD5::hash(
+        llvm::ArrayRef<uint8_t>(DSLStdlibBitcode, DSLStdlibBitcodeSize));
+    return std::string(hash.digest());
+}
@@ -0,0 +1,294 @@
+#include "agents/TierUpAgent.h"
+#include "agents/OptimizationAgent.h"
+#include "utils/Logger.h"
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+
+TierUpAgent::TierUpAgent(llvm::orc::LLJIT& jit, uint64_t threshold)
+    : jit(jit), threshold(threshold) {
+}
+
+TierUpAgent::~TierUpAgent() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+std::string TierUpAgent::baselineName(const std::string& function) {
+    return "__dsl_tier0." + function;
+}
+
+std::string TierUpAgent::optimizedName(const std::string& function) {
+    return "__dsl_tier2." + function;
+}
+
+bool TierUpAgent::initialize() {
+    auto hostBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!hostBuilder) {
+        LOG_ERROR("TierUpAgent: Cannot detect host target");
+        llvm::logAllUnhandledErrors(hostBuilder.takeError(), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    hostBuilder->setCodeGenOptLevel(llvm::CodeGenOptLevel::Aggressive);
+    // Same models LLJIT picks for JITLink, so optimized objects link like the baseline
+    hostBuilder->setRelocationModel(llvm::Reloc::PIC_);
+    hostBuilder->setCodeModel(llvm::CodeModel::Small);
+    auto targetMachine = hostBuilder->createTargetMachine();
+    if (!targetMachine) {
+        LOG_ERROR("TierUpAgent: Cannot create optimizing target machine");
+        llvm::logAllUnhandledErrors(targetMachine.takeError(), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    optimizingTarget = std::move(*targetMachine);
+    
+    stubs = llvm::orc::createLocalIndirectStubsManagerBuilder(jit.getTargetTriple())();
+    if (!stubs) {
+        LOG_ERROR("TierUpAgent: No indirect stubs for " + jit.getTargetTriple().str());
+        return false;
+    }
+    
+    llvm::orc::SymbolMap hooks;
+    hooks[jit.mangleAndIntern(TierUpHookName)] = {
+        llvm::orc::ExecutorAddr::fromPtr(&TierUpAgent::tierUp),
+        llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+    if (auto err = jit.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(hooks)))) {
+        LOG_ERROR("TierUpAgent: Cannot define the tier-up hook");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    
+    worker = std::thread([this] { workerLoop(); });
+    return true;
+}
+
+std::vector<std::string> TierUpAgent::instrument(llvm::Module& module) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t moduleIndex = moduleBitcode.size();
+    
+    // Recompiled code must update the baseline's mutable globals (profile counters
+    // among them), not private copies, so they become hidden definitions with
+    // names unique to this module that the optimizing tier declares
+    unsigned globalIndex = 0;
+    for (auto& global : module.globals()) {
+        if (global.isDeclaration() || !global.hasLocalLinkage() || global.isConstant()) continue;
+        std::string suffix = global.hasName() ? global.getName().str() : std::to_string(globalIndex++);
+        global.setName("__dsl_tier_global." + std::to_string(moduleIndex) + "." + suffix);
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        global.setVisibility(llvm::GlobalValue::HiddenVisibility);
+    }
+    
+    std::string bitcode;
+    {
+        llvm::raw_string_ostream OS(bitcode);
+        llvm::WriteBitcodeToFile(module, OS);
+    }
+    moduleBitcode.push_back(std::move(bitcode));
+    
+    llvm::LLVMContext& ctx = module.getContext();
+    llvm::Type* i32Type = llvm::Type::getInt32Ty(ctx);
+    llvm::Type* i64Type = llvm::Type::getInt64Ty(ctx);
+    llvm::Type* ptrType = llvm::PointerType::getUnqual(ctx);
+    llvm::FunctionCallee hook = module.getOrInsertFunction(
+        TierUpHookName, llvm::Type::getVoidTy(ctx), ptrType, i32Type);
+    llvm::Constant* self = llvm::ConstantExpr::getIntToPtr(
+        llvm::ConstantInt::get(i64Type, reinterpret_cast<uint64_t>(this)), ptrType);
+    
+    // Compiler-internal helpers (trampolines, profile dumps) are not worth tiering
+    std::vector<llvm::Function*> targets;
+    for (auto& func : module) {
+        if (func.isDeclaration() || !func.hasExternalLinkage()) continue;
+        if (func.getName().starts_with("__")) continue;
+        targets.push_back(&func);
+    }
+    
+    std::vector<std::string> names;
+    for (llvm::Function* func : targets) {
+        std::string name = func->getName().str();
+        uint32_t id = static_cast<uint32_t>(functions.size());
+        functions.push_back({name, moduleIndex});
+        names.push_back(name);
+        
+        // Count calls on entry; the call that reaches the threshold asks for the optimizing tier.
+        // The DSL has no loops, so hot recursion shows up as entry counts too. The
+        // increment is atomic so concurrent callers (--batch-threads) cannot skip the threshold
+        auto* counter = new llvm::GlobalVariable(module, i64Type, false, llvm::GlobalValue::InternalLinkage,
+                                                 llvm::ConstantInt::get(i64Type, 0), "__dsl_calls." + name);
+        auto insertPoint = func->getEntryBlock().begin();
+        while (llvm::isa<llvm::AllocaInst>(*insertPoint)) {
+            ++insertPoint;
+        }
+        llvm::IRBuilder<> builder(&*insertPoint);
+        llvm::Value* previous = builder.CreateAtomicRMW(llvm::AtomicRMWInst::Add, counter, builder.getInt64(1),
+                                                       llvm::MaybeAlign(8), llvm::AtomicOrdering::Monotonic);
+        llvm::Value* count = builder.CreateAdd(previous, builder.getInt64(1));
+        llvm::Value* hot = builder.CreateICmpEQ(count, builder.getInt64(threshold));
+        llvm::Instruction* requestTierUp = llvm::SplitBlockAndInsertIfThen(hot, insertPoint, false);
+        llvm::IRBuilder<>(requestTierUp).CreateCall(hook, {self, builder.getInt32(id)});
+        
+        // Every call, recursive ones included, goes through the stub that owns the name
+        func->setName(baselineName(name));
+        auto* stub = llvm::Function::Create(func->getFunctionType(), llvm::Function::ExternalLinkage, name, module);
+        func->replaceAllUsesWith(stub);
+    }
+    
+    return names;
+}
+
+bool TierUpAgent::addModule(llvm::orc::ThreadSafeModule module) {
+    std::vector<std::string> names;
+    module.withModuleDo([&](llvm::Module& M) { names = instrument(M); });
+    
+    // The stubs must exist before the baseline code, whose calls bind to them
+    llvm::JITSymbolFlags flags = llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable;
+    llvm::orc::StubInitsMap inits;
+    for (const auto& name : names) {
+        inits[name] = {llvm::orc::ExecutorAddr(), flags};
+    }
+    if (auto err = stubs->createStubs(inits)) {
+        LOG_ERROR("TierUpAgent: Cannot create stubs");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    
+    llvm::orc::SymbolMap stubSymbols;
+    for (const auto& name : names) {
+        stubSymbols[jit.mangleAndIntern(name)] = stubs->findStub(name, false);
+    }
+    if (auto err = jit.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(stubSymbols)))) {
+        LOG_ERROR("TierUpAgent: Cannot define stub symbols");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    
+    if (auto err = jit.addIRModule(std::move(module))) {
+        LOG_ERROR("TierUpAgent: Failed to add baseline module");
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+        return false;
+    }
+    
+    for (const auto& name : names) {
+        auto baseline = jit.lookup(baselineName(name));
+        if (!baseline) {
+            LOG_ERROR("TierUpAgent: Baseline compile failed for " + name);
+            llvm::logAllUnhandledErrors(baseline.takeError(), llvm::errs(), "JIT Error: ");
+            return false;
+        }
+        if (auto err = stubs->updatePointer(name, *baseline)) {
+            llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "JIT Error: ");
+            return false;
+        }
+    }
+    
+    LOG_INFO("TierUpAgent: " + std::to_string(names.size()) + " function(s) running at the baseline tier");
+    return true;
+}
+
+void TierUpAgent::tierUp(TierUpAgent* agent, uint32_t id) {
+    {
+        std::lock_guard<std::mutex> lock(agent->mutex);
+        TieredFunction& function = agent->functions[id];
+        if (function.requested) {
+            return;
+        }
+        function.requested = true;
+        agent->queue.push_back(id);
+    }
+    agent->wake.notify_one();
+}
+
+void TierUpAgent::workerLoop() {
+    while (true) {
+        uint32_t id;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) {
+                return;
+            }
+            id = queue.front();
+            queue.pop_front();
+        }
+        recompile(id);
+    }
+}
+
+void TierUpAgent::recompile(uint32_t id) {
+    std::string name;
+    std::string bitcode;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        name = functions[id].name;
+        bitcode = moduleBitcode[functions[id].moduleIndex];
+    }
+    
+    llvm::LLVMContext ctx;
+    auto moduleOrError = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, name), ctx);
+    if (!moduleOrError) {
+        llvm::logAllUnhandledErrors(moduleOrError.takeError(), llvm::errs(), "Tier-up Error: ");
+        return;
+    }
+    std::unique_ptr<llvm::Module> module = std::move(*moduleOrError);
+    llvm::Function* target = module->getFunction(name);
+    if (!target) {
+        return;
+    }
+    
+    // Only the hot function is emitted. Other definitions stay visible to the
+    // inliner but resolve to the running code (through their stubs) when called
+    for (auto& func : *module) {
+        if (&func == target || func.isDeclaration() || func.hasLocalLinkage()) continue;
+        func.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+        func.setComdat(nullptr);
+    }
+    // Globals, including those instrument() exported, resolve to the baseline's
+    // definitions; only constants are still local and may be copied
+    for (auto& global : module->globals()) {
+        if (global.isDeclaration() || global.hasLocalLinkage()) continue;
+        global.setInitializer(nullptr);
+        global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        global.setComdat(nullptr);
+    }
+    target->setName(optimizedName(name));
+    
+    module->setDataLayout(optimizingTarget->createDataLayout());
+    module->setTargetTriple(optimizingTarget->getTargetTriple());
+    
+    OptimizationAgent optAgent(3);
+    optAgent.optimize(module.get());
+    
+    llvm::orc::SimpleCompiler compile(*optimizingTarget);
+    auto object = compile(*module);
+    if (!object) {
+        llvm::logAllUnhandledErrors(object.takeError(), llvm::errs(), "Tier-up Error: ");
+        return;
+    }
+    if (auto err = jit.addObjectFile(std::move(*object))) {
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "Tier-up Error: ");
+        return;
+    }
+    
+    auto optimized = jit.lookup(optimizedName(name));
+    if (!optimized) {
+        llvm::logAllUnhandledErrors(optimized.takeError(), llvm::errs(), "Tier-up Error: ");
+        return;
+    }
+    
+    // A single pointer store: callers see either the baseline or the optimized code
+    if (auto err = stubs->updatePointer(name, *optimized)) {
+        llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "Tier-up Error: ");
+        return;
+    }
+    LOG_INFO("TierUpAgent: " + name + " recompiled at O3");
+}
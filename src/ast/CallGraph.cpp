@@ -0,0 +1,127 @@
+#include "ast/CallGraph.h"
+#include <algorithm>
+#include <functional>
+
+namespace ast {
+
+CallGraph::CallGraph(Program* program) {
+    for (const auto& func : program->functions) {
+        functions.emplace(func->name, func.get());
+        definitionOrder.push_back(func.get());
+    }
+
+    for (const auto& func : program->functions) {
+        std::vector<std::string>& callees = calleeNames[func.get()];
+        for (const auto& stmt : func->body) {
+            switch (stmt->type) {
+                case ASTNodeType::Return:
+                    collectCalls(static_cast<ReturnStmt*>(stmt.get())->expr.get(), callees);
+                    break;
+                case ASTNodeType::Let:
+                    collectCalls(static_cast<LetStmt*>(stmt.get())->value.get(), callees);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        std::vector<Function*>& targets = edges[func.get()];
+        for (const auto& callee : callees) {
+            Function* target = lookup(callee);
+            if (target && std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                targets.push_back(target);
+            }
+        }
+    }
+
+    computeSCCs();
+}
+
+void CallGraph::collectCalls(Expr* expr, std::vector<std::string>& callees) {
+    if (!expr) return;
+
+    switch (expr->type) {
+        case ASTNodeType::BinaryExpr: {
+            auto* binary = static_cast<BinaryExpr*>(expr);
+            collectCalls(binary->left.get(), callees);
+            collectCalls(binary->right.get(), callees);
+            break;
+        }
+        case ASTNodeType::UnaryExpr:
+            collectCalls(static_cast<UnaryExpr*>(expr)->operand.get(), callees);
+            break;
+        case ASTNodeType::Call: {
+            auto* call = static_cast<CallExpr*>(expr);
+            if (std::find(callees.begin(), callees.end(), call->callee) == callees.end()) {
+                callees.push_back(call->callee);
+            }
+            for (const auto& arg : call->args) {
+                collectCalls(arg.get(), callees);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void CallGraph::computeSCCs() {
+    // Tarjan's algorithm emits components in reverse topological order,
+    // which is exactly callees-before-callers
+    std::unordered_map<Function*, size_t> index;
+    std::unordered_map<Function*, size_t> lowLink;
+    std::unordered_map<Function*, bool> onStack;
+    std::vector<Function*> stack;
+    size_t nextIndex = 0;
+
+    std::function<void(Function*)> visit = [&](Function* func) {
+        index[func] = lowLink[func] = nextIndex++;
+        stack.push_back(func);
+        onStack[func] = true;
+
+        for (Function* callee : edges[func]) {
+            if (!index.count(callee)) {
+                visit(callee);
+                lowLink[func] = std::min(lowLink[func], lowLink[callee]);
+            } else if (onStack[callee]) {
+                lowLink[func] = std::min(lowLink[func], index[callee]);
+            }
+        }
+
+        if (lowLink[func] == index[func]) {
+            std::vector<Function*> component;
+            Function* member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                onStack[member] = false;
+                componentIndex[member] = components.size();
+                component.push_back(member);
+            } while (member != func);
+            components.push_back(std::move(component));
+        }
+    };
+
+    for (Function* func : definitionOrder) {
+        if (!index.count(func)) {
+            visit(func);
+        }
+    }
+}
+
+Function* CallGraph::lookup(const std::string& name) const {
+    auto it = functions.find(name);
+    return it == functions.end() ? nullptr : it->second;
+}
+
+const std::vector<std::string>& CallGraph::getCallees(Function* func) const {
+    return calleeNames.at(func);
+}
+
+bool CallGraph::isRecursive(Function* func) const {
+    if (components[getSCCIndex(func)].size() > 1) return true;
+    const auto& targets = edges.at(func);
+    return std::find(targets.begin(), targets.end(), func) != targets.end();
+}
+
+} // namespace ast
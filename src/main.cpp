@@ -9,18 +9,36 @@
 #include "agents/LinkerAgent.h"
 #include "agents/DiagnosticsAgent.h"
 #include "agents/SanitizerAgent.h"
+#include "agents/ProfileAgent.h"
+#include "agents/LTOAgent.h"
+#include "agents/CompileCacheAgent.h"
+#include "agents/IncrementalAgent.h"
+#include "agents/StdlibAgent.h"
+#include "agents/ReplAgent.h"
+#include "agents/JITCacheAgent.h"
+#include "agents/InvocationAgent.h"
+#include "agents/BatchAgent.h"
+#include "agents/BenchmarkAgent.h"
+#include "agents/PerfCounterAgent.h"
+#include "agents/SpecializationAgent.h"
+#include "agents/InterpreterAgent.h"
 #include "utils/Logger.h"
+#include "utils/StageTimer.h"
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
 #include <llvm/IR/Module.h>
-#include <llvm/Transforms/Utils/Cloning.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <algorithm>
+#include <unordered_set>
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
 
 using namespace llvm::cl;
 
-static opt<std::string> InputFilename(Positional, desc("<input DSL file>"), Required);
+static list<std::string> InputFilenames(Positional, desc("<input DSL, .ll or .bc files>"), ZeroOrMore);
 static opt<std::string> OutputFilename("o", desc("Output filename"), value_desc("filename"));
 static opt<bool> EmitIR("emit-ir", desc("Emit LLVM IR"));
 static opt<bool> EmitObject("emit-obj", desc("Emit object file"));
@@ -34,64 +52,722 @@ static opt<bool> EnableASan("asan", desc("Enable AddressSanitizer"));
 static opt<bool> EnableUBSan("ubsan", desc("Enable UndefinedBehaviorSanitizer"));
 static opt<bool> Verbose("v", desc("Verbose output"));
 static opt<bool> Link("link", desc("Link object file to executable"));
+static opt<bool> EmitShared("emit-shared", desc("Link a PIC shared library and generate a C header"));
+static opt<bool> EmitStatic("emit-static", desc("Archive the object into a static library and generate a C header"));
+static opt<bool> ProfileGenerate("profile-generate", desc("Instrument the program to collect an execution profile"));
+static opt<std::string> ProfileOutput("profile-output", desc("Profile file written by an instrumented run"),
+                                      value_desc("filename"), init("default.dslprof"));
+static opt<bool> HotColdSplit("hot-cold-split", desc("Split cold code out and order hot functions (implied by --profile-use)"));
+static opt<LTOMode> LTO("lto", desc("Link-time optimization across input files"), init(LTOMode::None),
+                        values(clEnumValN(LTOMode::None, "none", "Link input modules without LTO"),
+                               clEnumValN(LTOMode::Full, "full", "Merge and optimize as one module"),
+                               clEnumValN(LTOMode::Thin, "thin", "Summary-based ThinLTO with parallel backends")));
+static opt<unsigned> IRGenThreads("irgen-threads", desc("Generate IR for each input on N threads"), init(1));
+static opt<unsigned> CodegenThreads("j", desc("Run backend code generation on N threads"), value_desc("threads"), init(1), Prefix);
+static opt<unsigned> LTOJobs("lto-jobs", desc("ThinLTO backend threads (0 = all cores)"), init(0));
+static opt<std::string> ProfileUse("profile-use", desc("Optimize using a previously collected profile"), value_desc("filename"));
+static opt<std::string> CacheDir("cache-dir", desc("Reuse object files from a persistent compile cache"), value_desc("directory"));
+static opt<unsigned> CacheSizeMB("cache-size", desc("Compile cache size limit in MiB"), init(1024));
+static opt<bool> CacheStatsFlag("cache-stats", desc("Print compile cache statistics"));
+static opt<bool> Incremental("incremental", desc("Reuse optimized IR of unchanged functions (needs --cache-dir)"));
+static opt<bool> Repl("repl", desc("Keep a JIT session open and read commands from stdin"));
+static opt<bool> JITLazy("jit-lazy", desc("Optimize and compile each function on its first call (with --jit)"));
+static opt<bool> JITTiered("jit-tiered", desc("Start at O0 and recompile hot functions at O3 in the background (with --jit)"));
+static opt<unsigned> TierUpThreshold("tier-up-threshold", desc("Calls before a tiered function is recompiled"), init(1000));
+static opt<unsigned> JITThreads("jit-threads", desc("Compile JIT code on N threads"), init(0));
+static opt<bool> JITPerfMap("jit-perf-map", desc("Write /tmp/perf-<pid>.map so perf can symbolize JITed code"));
+static opt<bool> JITDebug("jit-debug", desc("Register JITed code with GDB's JIT interface"));
+static opt<std::string> Entry("entry", desc("Function to run with --jit instead of main()"), value_desc("function"));
+static list<std::string> EntryArgs("args", desc("Comma-separated arguments for --entry"), CommaSeparated);
+static opt<std::string> BatchInput("batch", desc("Call --entry once per argument tuple in a CSV or .bin file"), value_desc("filename"));
+static opt<std::string> BatchOutput("batch-output", desc("Write --batch results to a file (.bin for packed slots)"), value_desc("filename"));
+static opt<unsigned> BatchThreads("batch-threads", desc("Run --batch calls on N threads"), init(1));
+static opt<std::string> Bench("bench", desc("Time N runs of --entry or main() after compiling (default 1000)"),
+                               value_desc("N"), ValueOptional);
+static opt<unsigned> BenchWarmup("bench-warmup", desc("Untimed runs before --bench measures"), init(100));
+static opt<std::string> BenchJSON("bench-json", desc("Also write --bench results as JSON (- for stdout)"), value_desc("filename"));
+static opt<bool> PerfStat("perf-stat", desc("Count cycles, instructions, branch and cache misses of JITed runs (Linux)"));
+static list<std::string> Specialize("specialize", desc("JIT a copy of a function with parameters fixed to constants"),
+                                    value_desc("fn:param=value,..."));
+static opt<InterpMode> Interp("interp", desc("Run --entry or main() from the AST without compiling"), init(InterpMode::Off),
+                              ValueOptional,
+                              values(clEnumValN(InterpMode::Always, "always", "Always interpret (the default)"),
+                                     clEnumValN(InterpMode::Always, "", ""),
+                                     clEnumValN(InterpMode::Auto, "auto", "Interpret short runs, JIT the rest")));
+static opt<uint64_t> InterpCutoff("interp-cutoff", desc("Estimated evaluations above which --interp=auto uses the JIT"),
+                                  init(InterpreterAgent::DefaultCutoff));
+static opt<bool> TimeStages("time-stages", desc("Report wall-clock time per compiler stage"));
+
+// --bench iterations; 0 when not benchmarking
+static unsigned benchIterations() {
+    if (Bench.getNumOccurrences() == 0) {
+        return 0;
+    }
+    unsigned iterations = 1000;
+    if (!Bench.empty() && (llvm::StringRef(Bench).getAsInteger(10, iterations) || iterations == 0)) {
+        LOG_WARNING("Invalid --bench count " + Bench + ", using 1000");
+        iterations = 1000;
+    }
+    return iterations;
+}
+
+static bool reportBenchmark(const BenchmarkResult& result) {
+    BenchmarkAgent::printText(result);
+    return BenchJSON.empty() || BenchmarkAgent::writeJSON(result, BenchJSON);
+}
+
+// Runs --entry once with --args, or over every tuple of --batch; --bench times
+// repeated calls with --args instead. Counters, when given, cover only the calls
+static bool runEntry(EntryTrampoline entry, const ast::Function& signature, PerfCounterAgent* counters) {
+    BatchAgent batchAgent(entry, signature);
+    if (!BatchInput.empty() && !benchIterations()) {
+        std::vector<InvocationSlot> inputs;
+        if (!batchAgent.readInputs(BatchInput, inputs)) {
+            return false;
+        }
+        // Counters follow the calling thread only
+        unsigned threads = BatchThreads;
+        if (counters && threads > 1) {
+            LOG_WARNING("--perf-stat runs --batch on one thread");
+            threads = 1;
+        }
+        std::vector<InvocationSlot> results;
+        if (counters) counters->start();
+        batchAgent.run(inputs, results, threads);
+        if (counters) {
+            counters->stop();
+            counters->report(signature.name, results.size());
+        }
+        return batchAgent.writeResults(BatchOutput, results);
+    }
+    
+    std::vector<InvocationSlot> args;
+    if (!batchAgent.parseArguments(std::vector<std::string>(EntryArgs.begin(), EntryArgs.end()), args)) {
+        return false;
+    }
+    InvocationSlot value = {};
+    
+    if (unsigned iterations = benchIterations()) {
+        LOG_INFO("\n[Agent 19] Benchmark Agent");
+        StageTimer::begin("Benchmark");
+        BenchmarkAgent benchAgent(iterations, BenchWarmup);
+        benchAgent.setCounters(counters);
+        bool reported = reportBenchmark(benchAgent.measure(signature.name, [&] {
+            entry(args.data(), &value);
+            BenchmarkAgent::doNotOptimize(&value);
+        }));
+        if (counters) {
+            counters->report(signature.name, iterations);
+        }
+        return reported;
+    }
+    
+    if (counters) counters->start();
+    entry(args.data(), &value);
+    if (counters) counters->stop();
+    std::string result = InvocationAgent::formatValue(value, signature.returnType);
+    if (!result.empty()) {
+        std::cout << result << std::endl;
+    }
+    if (counters) {
+        counters->report(signature.name, 1);
+    }
+    return true;
+}
+
+// Runs --entry with --args, or main(), on the interpreter. False when
+// --interp=auto leaves the program to the JIT; exitCode is set otherwise
+static bool interpret(const std::vector<std::unique_ptr<ast::Program>>& programs, bool hasIRInputs, int& exitCode) {
+    LOG_INFO("\n[Agent 22] Interpreter Agent");
+    StageTimer::begin("Interpreter");
+    bool automatic = Interp == InterpMode::Auto;
+    std::string name = Entry.empty() ? std::string("main") : std::string(Entry);
+    exitCode = 1;
+    
+    // Anything that needs compiled code or writes output is left to the pipeline
+    bool needsCompiler = hasIRInputs || !BatchInput.empty() || benchIterations() || PerfStat ||
+                         !Specialize.empty() || ProfileGenerate || EnableASan || EnableUBSan || DumpIR ||
+                         EmitIR || EmitObject || EmitBitcode || EmitAssembly || EmitShared || EmitStatic || Link ||
+                         !OutputFilename.empty();
+    if (automatic && needsCompiler) {
+        LOG_INFO("InterpreterAgent: Options need compiled code, using the JIT");
+        return false;
+    }
+    if (hasIRInputs) {
+        LOG_ERROR("--interp cannot run LLVM IR inputs");
+        return true;
+    }
+    if (needsCompiler) {
+        LOG_WARNING("--interp only runs the program; output, batch, benchmark and instrumentation options are ignored");
+    }
+    
+    InterpreterAgent interpreter;
+    if (!interpreter.load(programs)) {
+        if (automatic) {
+            LOG_INFO("InterpreterAgent: Program is not interpretable, using the JIT");
+        }
+        return !automatic;
+    }
+    const ast::Function* signature = interpreter.getFunction(name);
+    if (!signature) {
+        if (automatic) {
+            return false;
+        }
+        LOG_ERROR("No " + name + "() function to interpret");
+        return true;
+    }
+    
+    // Below the cutoff, the run costs less than compiling it would
+    if (automatic) {
+        uint64_t cost = interpreter.estimateCost(name);
+        if (cost > InterpCutoff) {
+            LOG_INFO("InterpreterAgent: " + name + " is too expensive to interpret, using the JIT");
+            return false;
+        }
+        LOG_INFO("InterpreterAgent: Interpreting " + name + " (about " + std::to_string(cost) + " evaluations)");
+    }
+    
+    std::vector<InvocationSlot> args;
+    std::vector<std::string> argText(EntryArgs.begin(), EntryArgs.end());
+    if (argText.size() != signature->params.size()) {
+        LOG_ERROR(name + " takes " + std::to_string(signature->params.size()) + " argument(s), got " +
+                  std::to_string(argText.size()));
+        return true;
+    }
+    for (size_t i = 0; i < argText.size(); i++) {
+        InvocationSlot slot = {};
+        if (!InvocationAgent::parseValue(argText[i], signature->params[i].second, slot)) {
+            LOG_ERROR("Invalid value for " + signature->params[i].first + ": " + argText[i]);
+            return true;
+        }
+        args.push_back(slot);
+    }
+    
+    InvocationSlot value = {};
+    if (!interpreter.call(name, args, value)) {
+        return true;
+    }
+    StageTimer::end();
+    std::string result = InvocationAgent::formatValue(value, signature->returnType);
+    if (Entry.empty()) {
+        LOG_INFO("Program returned: " + result);
+    } else if (!result.empty()) {
+        std::cout << result << std::endl;
+    }
+    exitCode = 0;
+    return true;
+}
+
+static void linkExecutable(const std::vector<std::string>& objects, const std::string& objectFile,
+                           const std::string& orderFile, bool benchmark) {
+    LOG_INFO("\n[Agent 10] Linker Agent");
+    StageTimer::begin("Linker");
+    std::string exeFile = objectFile;
+    if (llvm::sys::path::extension(exeFile) == ".o") {
+        exeFile = exeFile.substr(0, exeFile.size() - 2);
+    }
+    exeFile += ".out";
+    
+    // Try lld first, fall back to system linker
+    bool linked = LinkerAgent::linkWithLLD(objects, exeFile, {}, orderFile);
+    if (!linked) {
+        LOG_WARNING("lld not available, trying system linker");
+        linked = LinkerAgent::linkWithSystemLinker(objects, exeFile);
+    }
+    
+    // Agent 19: Benchmark Agent (AOT: whole runs of the executable)
+    if (linked && benchmark) {
+        LOG_INFO("\n[Agent 19] Benchmark Agent");
+        StageTimer::begin("Benchmark");
+        BenchmarkResult result;
+        BenchmarkAgent benchAgent(benchIterations(), BenchWarmup);
+        if (benchAgent.measureExecutable(exeFile, result)) {
+            reportBenchmark(result);
+        }
+    }
+}
 
 int main(int argc, char** argv) {
     llvm::cl::ParseCommandLineOptions(argc, argv, "LLVM DSL Compiler\n");
     
     LOG_INFO("=== LLVM DSL Compiler ===");
+    StageTimer::setEnabled(TimeStages);
+    
+    // --interp=auto always runs the program, on the JIT when it is not interpreted
+    if (Interp == InterpMode::Auto) {
+        RunJIT = true;
+    }
+    
+    // Agent 17: REPL Agent (the inputs are loaded into the session)
+    if (Repl) {
+        LOG_INFO("\n[Agent 17] REPL Agent");
+        JITAgent jitAgent;
+        jitAgent.setPerfMap(JITPerfMap);
+        jitAgent.setDebuggerSupport(JITDebug);
+        if (!jitAgent.initialize()) {
+            return 1;
+        }
+        ReplAgent repl(jitAgent, NoOptimize ? 0 : static_cast<int>(OptLevel));
+        for (const auto& inputFile : InputFilenames) {
+            repl.load(inputFile);
+        }
+        repl.run(std::cin);
+        return 0;
+    }
     
-    // Parse source code
-    std::string source;
-    try {
-        source = ParserAgent::readFile(InputFilename);
-    } catch (const std::exception& e) {
-        LOG_ERROR("Failed to read input file: " + std::string(e.what()));
+    if (InputFilenames.empty()) {
+        LOG_ERROR("No input files");
         return 1;
     }
     
     DiagnosticsAgent diagnostics;
     
+    StageTimer::begin("Read inputs");
+    std::vector<std::string> sources;
+    for (const auto& inputFile : InputFilenames) {
+        try {
+            sources.push_back(ParserAgent::readFile(inputFile));
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to read input file: " + std::string(e.what()));
+            return 1;
+        }
+    }
+    
+    bool splitHotCold = HotColdSplit || !ProfileUse.empty();
+    // Only profiled entry counts mark code hot or cold; DSL functions carry no hot/cold attributes
+    if (HotColdSplit && ProfileUse.empty()) {
+        diagnostics.addDiagnostic(Diagnostic::Warning, "--hot-cold-split needs --profile-use to find cold code");
+    }
+    std::string outputFile = OutputFilename;
+    if (outputFile.empty()) {
+        outputFile = InputFilenames.front() + ".o";
+    }
+    
+    // Compile cache: object-only builds are looked up before any agent runs.
+    // Link-time ordering files are not cached, so hot/cold links always rebuild
+    std::unique_ptr<CompileCacheAgent> compileCache;
+    if (!CacheDir.empty()) {
+        compileCache = std::make_unique<CompileCacheAgent>(CacheDir, uint64_t(CacheSizeMB) << 20);
+        if (!compileCache->initialize()) {
+            compileCache.reset();
+        }
+    }
+    bool cacheable = compileCache && (EmitObject || !OutputFilename.empty()) && !RunJIT && !DumpIR &&
+                     Interp == InterpMode::Off &&
+                     !EmitShared && !EmitStatic &&
+                     !EmitIR && !EmitBitcode && !EmitAssembly && LTO != LTOMode::Thin && !(Link && splitHotCold) &&
+                     CodegenAgent::formatForFilename(outputFile) == OutputFormat::Object;
+    
+    std::vector<std::string> cacheFlags = {
+        "O=" + std::to_string(NoOptimize ? 0 : static_cast<int>(OptLevel)),
+        "cpu=generic", "features=",
+        "asan=" + std::to_string(EnableASan), "ubsan=" + std::to_string(EnableUBSan),
+        "lto=" + std::to_string(static_cast<int>(LTO.getValue())),
+        "hot-cold=" + std::to_string(splitHotCold),
+        "profile-generate=" + (ProfileGenerate ? std::string(ProfileOutput) : std::string()),
+        "stdlib=" + StdlibAgent::getContentHash()};
+    if (!ProfileUse.empty()) {
+        try {
+            cacheFlags.push_back("profile=" + ParserAgent::readFile(ProfileUse));
+        } catch (const std::exception&) {
+            // A missing profile is reported by the profile agent
+        }
+    }
+    
+    std::string cacheKey;
+    if (cacheable) {
+        LOG_INFO("\n[Agent 14] Compile Cache Agent");
+        StageTimer::begin("Compile Cache");
+        std::vector<std::string> keySources;
+        for (size_t i = 0; i < sources.size(); i++) {
+            keySources.push_back(InputFilenames[i]);
+            keySources.push_back(sources[i]);
+        }
+        cacheKey = CompileCacheAgent::computeKey(keySources, cacheFlags, ModuleSetupAgent::getDefaultTriple());
+        
+        if (compileCache->lookup(cacheKey, outputFile)) {
+            if (Link) {
+                linkExecutable({outputFile}, outputFile, "", benchIterations() > 0);
+            }
+            StageTimer::report();
+            if (CacheStatsFlag) {
+                compileCache->printStats();
+            }
+            LOG_INFO("\n=== Compilation successful (cached) ===");
+            return 0;
+        }
+    }
+    
     // Agent 1: Parser Agent
+    // LLVM IR inputs are loaded into the shared context and join the DSL modules before LTO
     LOG_INFO("\n[Agent 1] Parser Agent");
-    ParserAgent parserAgent(source);
-    std::unique_ptr<ast::Program> program;
-    try {
-        program = parserAgent.parse();
-    } catch (const std::exception& e) {
-        diagnostics.addDiagnostic(Diagnostic::Error, "Parse error: " + std::string(e.what()));
-        diagnostics.printDiagnostics();
-        return 1;
+    StageTimer::begin("Parser");
+    // Owned separately so --jit can hand it to the JIT together with the final module
+    auto contextOwner = std::make_unique<llvm::LLVMContext>();
+    llvm::LLVMContext& context = *contextOwner;
+    std::vector<std::unique_ptr<ast::Program>> programs;
+    std::vector<std::string> programFiles;
+    std::vector<std::unique_ptr<llvm::Module>> irModules;
+    for (size_t i = 0; i < sources.size(); i++) {
+        const std::string& inputFile = InputFilenames[i];
+        const std::string& source = sources[i];
+        if (ParserAgent::isIRFile(inputFile)) {
+            auto irModule = ParserAgent::loadIRFile(inputFile, context);
+            if (!irModule) {
+                diagnostics.addDiagnostic(Diagnostic::Error, "Cannot load LLVM IR from " + inputFile);
+                diagnostics.printDiagnostics();
+                return 1;
+            }
+            irModules.push_back(std::move(irModule));
+            continue;
+        }
+        programFiles.push_back(inputFile);
+        ParserAgent parserAgent(source);
+        try {
+            programs.push_back(parserAgent.parse());
+        } catch (const std::exception& e) {
+            diagnostics.addDiagnostic(Diagnostic::Error, "Parse error in " + inputFile + ": " + std::string(e.what()));
+            diagnostics.printDiagnostics();
+            return 1;
+        }
     }
     
     // Agent 2: AST Agent
     LOG_INFO("\n[Agent 2] AST Agent");
-    ASTAgent::validateAST(program.get());
-    if (Verbose) {
-        ASTAgent::dumpAST(program.get());
+    StageTimer::begin("AST");
+    for (const auto& program : programs) {
+        ASTAgent::validateAST(program.get());
+        if (Verbose) {
+            ASTAgent::dumpAST(program.get());
+        }
+    }
+    
+    // Agent 22: Interpreter Agent (short runs skip IR generation and the JIT)
+    if (Interp != InterpMode::Off) {
+        int exitCode;
+        if (interpret(programs, !irModules.empty(), exitCode)) {
+            StageTimer::report();
+            if (exitCode == 0) {
+                LOG_INFO("\n=== Execution successful (interpreted) ===");
+            }
+            return exitCode;
+        }
+    }
+    
+    // Functions defined by IR inputs are callable from every DSL file
+    std::vector<std::unique_ptr<ast::Function>> irPrototypes;
+    for (const auto& irModule : irModules) {
+        for (auto& prototype : IRGenerationAgent::importPrototypes(*irModule)) {
+            irPrototypes.push_back(std::move(prototype));
+        }
+    }
+    
+    // Standard library functions are callable unless an input defines the same name
+    std::unordered_set<std::string> userFunctions;
+    for (const auto& program : programs) {
+        for (const auto& func : program->functions) {
+            userFunctions.insert(func->name);
+        }
+    }
+    for (const auto& prototype : irPrototypes) {
+        userFunctions.insert(prototype->name);
     }
+    std::vector<std::unique_ptr<ast::Function>> stdlibPrototypes = StdlibAgent::getPrototypes();
     
-    // Agent 3: IR Generation Agent
+    // Agent 3: IR Generation Agent (one module per input file)
     LOG_INFO("\n[Agent 3] IR Generation Agent");
-    llvm::LLVMContext context;
-    IRGenerationAgent irAgent(context);
-    irAgent.generate(program.get());
-    llvm::Module* module = irAgent.getModule();
+    StageTimer::begin("IR Generation");
+    std::vector<std::unique_ptr<llvm::Module>> modules;
+    for (size_t i = 0; i < programs.size(); i++) {
+        std::vector<ast::Function*> externals;
+        for (size_t j = 0; j < programs.size(); j++) {
+            if (j == i) continue;
+            for (const auto& func : programs[j]->functions) {
+                externals.push_back(func.get());
+            }
+        }
+        for (const auto& prototype : irPrototypes) {
+            externals.push_back(prototype.get());
+        }
+        for (const auto& prototype : stdlibPrototypes) {
+            if (!userFunctions.count(prototype->name)) {
+                externals.push_back(prototype.get());
+            }
+        }
+        
+        if (IRGenThreads > 1) {
+            auto inputModule = IRGenerationAgent::generateParallel(
+                programs[i].get(), externals, context, programFiles[i], IRGenThreads);
+            if (!inputModule) {
+                diagnostics.addDiagnostic(Diagnostic::Error, "Parallel IR generation failed for " + programFiles[i]);
+                diagnostics.printDiagnostics();
+                return 1;
+            }
+            modules.push_back(std::move(inputModule));
+        } else {
+            IRGenerationAgent irAgent(context, programFiles[i]);
+            for (ast::Function* func : externals) {
+                irAgent.declareFunction(func);
+            }
+            if (!irAgent.generate(programs[i].get())) {
+                diagnostics.addDiagnostic(Diagnostic::Error, "IR generation failed for " + programFiles[i]);
+                diagnostics.printDiagnostics();
+                return 1;
+            }
+            modules.push_back(irAgent.takeModule());
+        }
+    }
+    for (auto& irModule : irModules) {
+        modules.push_back(std::move(irModule));
+    }
     
     // Agent 4: Module Setup Agent
+    // IR inputs keep the target they were written for; the linker rejects a mismatch
     LOG_INFO("\n[Agent 4] Module Setup Agent");
+    StageTimer::begin("Module Setup");
     ModuleSetupAgent moduleAgent;
-    moduleAgent.setupModule(module);
+    for (const auto& inputModule : modules) {
+        if (inputModule->getTargetTriple().str().empty()) {
+            moduleAgent.setupModule(inputModule.get());
+        }
+    }
+    
+    // Agent 16: Stdlib Agent (before LTO, so library code can be inlined)
+    LOG_INFO("\n[Agent 16] Stdlib Agent");
+    StageTimer::begin("Stdlib");
+    for (const auto& inputModule : modules) {
+        if (!StdlibAgent::linkInto(inputModule.get())) {
+            diagnostics.addDiagnostic(Diagnostic::Error, "Failed to link the standard library");
+            diagnostics.printDiagnostics();
+            return 1;
+        }
+    }
+    
+    // Agent 13: LTO Agent
+    LTOAgent ltoAgent(NoOptimize ? 0 : static_cast<int>(OptLevel), LTOJobs);
+    ltoAgent.preserveSymbol("main");
+    ltoAgent.preserveSymbol(ProfileAgent::DumpFunctionName);
+    if (!Entry.empty()) {
+        ltoAgent.preserveSymbol(InvocationAgent::trampolineName(Entry));
+    }
+    // Specializations are copied from the named functions after LTO
+    for (const auto& request : Specialize) {
+        std::string function;
+        std::vector<std::pair<std::string, std::string>> constants;
+        if (SpecializationAgent::parseRequest(request, function, constants)) {
+            ltoAgent.preserveSymbol(function);
+        }
+    }
+    // A library exports every function its inputs define
+    if (EmitShared || EmitStatic) {
+        for (const auto& name : userFunctions) {
+            ltoAgent.preserveSymbol(name);
+        }
+    }
+    
+    if (LTO == LTOMode::Thin) {
+        LOG_INFO("\n[Agent 13] LTO Agent");
+        StageTimer::begin("LTO");
+        // The ThinLTO backends optimize and emit the objects themselves, so
+        // options that work on the merged module have nothing to apply to
+        std::vector<std::string> unsupported;
+        if (ProfileGenerate) unsupported.push_back("--profile-generate");
+        if (RunJIT) unsupported.push_back("--jit");
+        if (!ProfileUse.empty()) unsupported.push_back("--profile-use");
+        if (HotColdSplit) unsupported.push_back("--hot-cold-split");
+        if (EnableASan) unsupported.push_back("--asan");
+        if (EnableUBSan) unsupported.push_back("--ubsan");
+        if (EmitIR) unsupported.push_back("--emit-ir");
+        if (EmitAssembly) unsupported.push_back("--emit-asm");
+        if (CodegenThreads > 1) unsupported.push_back("-j");
+        if (Incremental) unsupported.push_back("--incremental");
+        if (EmitShared) unsupported.push_back("--emit-shared");
+        if (EmitStatic) unsupported.push_back("--emit-static");
+        if (!unsupported.empty()) {
+            std::string flags;
+            for (const auto& flag : unsupported) {
+                flags += (flags.empty() ? "" : ", ") + flag;
+            }
+            diagnostics.addDiagnostic(Diagnostic::Error, "--lto=thin does not support " + flags);
+            diagnostics.printDiagnostics();
+            return 1;
+        }
+        for (const auto& inputModule : modules) {
+            if (!VerificationAgent::verify(inputModule.get(), true)) {
+                diagnostics.addDiagnostic(Diagnostic::Error, "IR verification failed for " +
+                                          inputModule->getModuleIdentifier());
+                diagnostics.printDiagnostics();
+                return 1;
+            }
+        }
+        
+        if (EmitBitcode) {
+            for (const auto& inputModule : modules) {
+                LTOAgent::emitBitcodeWithSummary(inputModule.get(), inputModule->getModuleIdentifier() + ".bc");
+            }
+        }
+        
+        std::string outputPrefix = OutputFilename.empty() ? InputFilenames.front() : std::string(OutputFilename);
+        std::vector<std::string> objects;
+        if (!ltoAgent.runThinLTO(std::move(modules), outputPrefix, objects)) {
+            diagnostics.addDiagnostic(Diagnostic::Error, "ThinLTO failed");
+            diagnostics.printDiagnostics();
+            return 1;
+        }
+        
+        if (Link) {
+            LOG_INFO("\n[Agent 10] Linker Agent");
+            StageTimer::begin("Linker");
+            std::string exeFile = outputPrefix + ".out";
+            if (!LinkerAgent::linkWithLLD(objects, exeFile)) {
+                LOG_WARNING("lld not available, trying system linker");
+                LinkerAgent::linkWithSystemLinker(objects, exeFile);
+            }
+        }
+        
+        diagnostics.printDiagnostics();
+        StageTimer::report();
+        LOG_INFO("\n=== Compilation successful ===");
+        return 0;
+    }
+    
+    if (LTO == LTOMode::Full && !NoOptimize) {
+        LOG_INFO("\n[Agent 13] LTO Agent");
+        StageTimer::begin("LTO");
+        for (const auto& inputModule : modules) {
+            ltoAgent.optimizePreLink(inputModule.get());
+        }
+    }
+    
+    std::unique_ptr<llvm::Module> linkedModule;
+    if (modules.size() == 1) {
+        linkedModule = std::move(modules.front());
+    } else {
+        linkedModule = ltoAgent.linkModules(std::move(modules));
+        if (!linkedModule) {
+            diagnostics.addDiagnostic(Diagnostic::Error, "Failed to link input modules");
+            diagnostics.printDiagnostics();
+            return 1;
+        }
+    }
+    llvm::Module* module = linkedModule.get();
+    
+    // Agent 12: Profile Agent
+    if (ProfileGenerate || !ProfileUse.empty()) {
+        LOG_INFO("\n[Agent 12] Profile Agent");
+        StageTimer::begin("Profile");
+        if (ProfileGenerate && !ProfileUse.empty()) {
+            diagnostics.addDiagnostic(Diagnostic::Error, "--profile-generate and --profile-use are mutually exclusive");
+            diagnostics.printDiagnostics();
+            return 1;
+        }
+        if (ProfileGenerate) {
+            ProfileAgent::instrument(module, ProfileOutput);
+        } else {
+            ProfileAgent profileAgent;
+            if (!profileAgent.readProfile(ProfileUse) || !profileAgent.applyProfile(module)) {
+                diagnostics.addDiagnostic(Diagnostic::Warning, "Profile not applied: " + ProfileUse);
+            }
+        }
+    }
+    
+    // Agent 15: Incremental Agent
+    std::unique_ptr<IncrementalAgent> incrementalAgent;
+    if (Incremental) {
+        LOG_INFO("\n[Agent 15] Incremental Agent");
+        StageTimer::begin("Incremental");
+        if (!compileCache) {
+            diagnostics.addDiagnostic(Diagnostic::Warning, "--incremental needs --cache-dir, recompiling every function");
+        } else if (LTO != LTOMode::None || ProfileGenerate) {
+            diagnostics.addDiagnostic(Diagnostic::Warning, "--incremental is not supported with --lto or --profile-generate");
+        } else {
+            std::vector<ast::Program*> programList;
+            for (const auto& program : programs) {
+                programList.push_back(program.get());
+            }
+            // DSL functions may inline code from IR inputs, which have no AST to fingerprint
+            std::vector<std::string> incrementalFlags = cacheFlags;
+            for (size_t i = 0; i < sources.size(); i++) {
+                if (ParserAgent::isIRFile(InputFilenames[i])) {
+                    incrementalFlags.push_back("ir=" + sources[i]);
+                }
+            }
+            incrementalAgent = std::make_unique<IncrementalAgent>(*compileCache, incrementalFlags,
+                                                                  ModuleSetupAgent::getDefaultTriple());
+            incrementalAgent->computeKeys(programList);
+            incrementalAgent->prepare(module);
+        }
+    }
+    
+    // A lazy JIT run optimizes functions one at a time as they are first called.
+    // Anything that writes output or caches functions still needs the whole module optimized
+    bool emitsOutput = EmitIR || EmitObject || EmitBitcode || EmitAssembly || EmitShared || EmitStatic ||
+                       OutputFilename != "";
+    // With machine code output the JIT runs the emitted object instead of compiling the module
+    OutputFormat outputFormat = CodegenAgent::formatForFilename(outputFile);
+    bool emitsMachineCode = EmitObject || EmitAssembly || EmitShared || EmitStatic ||
+                            (!OutputFilename.empty() && !EmitIR && !EmitBitcode &&
+                             outputFormat != OutputFormat::LLVM_IR && outputFormat != OutputFormat::Bitcode);
+    bool tieredJIT = RunJIT && JITTiered && !emitsMachineCode;
+    bool lazyJIT = RunJIT && JITLazy && !emitsMachineCode && !tieredJIT;
+    bool deferOptimization = (lazyJIT || tieredJIT) && LTO == LTOMode::None && !incrementalAgent && !emitsOutput;
+    if (JITLazy && JITTiered) {
+        diagnostics.addDiagnostic(Diagnostic::Warning, "--jit-lazy is ignored with --jit-tiered");
+    }
+    if (RunJIT && emitsMachineCode && (JITLazy || JITTiered || JITThreads.getNumOccurrences() > 0)) {
+        diagnostics.addDiagnostic(Diagnostic::Warning,
+                                  "--jit-lazy, --jit-tiered and --jit-threads are ignored when writing object or "
+                                  "assembly output");
+    }
+    
+    // --entry calls go through a typed trampoline, created before optimization so
+    // the target can be inlined into it
+    std::unique_ptr<ast::Function> entrySignature;
+    if (benchIterations() && !RunJIT && !Link) {
+        diagnostics.addDiagnostic(Diagnostic::Warning, "--bench needs --jit or --link");
+    }
+    if (PerfStat && !RunJIT) {
+        diagnostics.addDiagnostic(Diagnostic::Warning, "--perf-stat needs --jit");
+    }
+    if (!Entry.empty()) {
+        if (!RunJIT) {
+            diagnostics.addDiagnostic(Diagnostic::Warning, "--entry is ignored without --jit");
+        } else {
+            for (auto& prototype : IRGenerationAgent::importPrototypes(*module)) {
+                if (prototype->name == Entry) {
+                    entrySignature = std::move(prototype);
+                }
+            }
+            if (!entrySignature || !InvocationAgent::createTrampoline(module->getFunction(Entry))) {
+                diagnostics.addDiagnostic(Diagnostic::Error, "Cannot call --entry function " + Entry);
+                diagnostics.printDiagnostics();
+                return 1;
+            }
+        }
+    }
     
     // Agent 5: Optimization Agent
     LOG_INFO("\n[Agent 5] Optimization Agent");
-    if (!NoOptimize) {
-        OptimizationAgent optAgent;
-        optAgent.configureOptimizationLevel(OptLevel);
+    StageTimer::begin("Optimization");
+    if (LTO == LTOMode::Full) {
+        ltoAgent.optimizeFullLTO(module);
+    } else if (!NoOptimize && !deferOptimization) {
+        OptimizationAgent optAgent(OptLevel);
         optAgent.optimize(module);
     }
     
+    if (incrementalAgent) {
+        if (!incrementalAgent->finish(module)) {
+            diagnostics.addDiagnostic(Diagnostic::Error, "Failed to link cached functions");
+            diagnostics.printDiagnostics();
+            return 1;
+        }
+        compileCache->prune();
+    }
+    
     // Agent 6: Verification Agent
     LOG_INFO("\n[Agent 6] Verification Agent");
+    StageTimer::begin("Verification");
     if (!VerificationAgent::verify(module, true)) {
         diagnostics.addDiagnostic(Diagnostic::Error, "IR verification failed");
         diagnostics.printDiagnostics();
@@ -100,86 +776,320 @@ int main(int argc, char** argv) {
     
     // Agent 7: Diagnostics Agent
     LOG_INFO("\n[Agent 7] Diagnostics Agent");
+    StageTimer::begin("Diagnostics");
     if (DumpIR || Verbose) {
         diagnostics.dumpIR(module, true);
     }
     
     // Agent 8: Sanitizer Agent
     LOG_INFO("\n[Agent 8] Sanitizer Agent");
+    StageTimer::begin("Sanitizer");
     if (EnableASan || EnableUBSan) {
         SanitizerAgent::addSanitizers(module, EnableASan, EnableUBSan);
     }
     
-    bool hasOutput = false;
+    // Declared ahead of codegen, which rewrites the module in place: specializations
+    // are copied from the program IR, so it is kept as bitcode
+    std::unique_ptr<JITCacheAgent> jitCache;
+    JITAgent jitAgent;
+    std::unique_ptr<SpecializationAgent> specializer;
+    if (RunJIT && !Specialize.empty()) {
+        if (tieredJIT) {
+            diagnostics.addDiagnostic(Diagnostic::Warning, "--specialize is ignored with --jit-tiered");
+        } else {
+            specializer = std::make_unique<SpecializationAgent>(jitAgent, NoOptimize ? 0 : static_cast<int>(OptLevel));
+            specializer->setModule(*module);
+        }
+    }
+    
+    // Objects the JIT loads instead of compiling the module
+    std::vector<std::string> emittedObjects;
+    std::string jitObjectFile;
     
     // Agent 9: Codegen Agent
-    if (EmitIR || EmitObject || EmitBitcode || EmitAssembly || OutputFilename != "") {
+    if (emitsOutput) {
         LOG_INFO("\n[Agent 9] Codegen Agent");
+        StageTimer::begin("Codegen");
         CodegenAgent codegenAgent;
+        codegenAgent.setHotColdSplitting(splitHotCold);
+        // JIT memory can lie anywhere in the address space, so objects the JIT
+        // loads are PIC with the small code model, as LLJIT builds its own code
+        codegenAgent.setPositionIndependent(EmitShared || RunJIT);
+        if (EmitShared) {
+            module->setPICLevel(llvm::PICLevel::BigPIC);
+        }
+        
+        // Libraries, their header and the object they are built from share -o's stem
+        std::string libraryBase = outputFile;
+        llvm::StringRef outputExt = llvm::sys::path::extension(outputFile);
+        if (outputExt == ".o" || outputExt == ".so" || outputExt == ".dylib" || outputExt == ".a") {
+            libraryBase = outputFile.substr(0, outputFile.size() - outputExt.size());
+        }
+        bool emitLibrary = EmitShared || EmitStatic;
         
-        std::string outputFile = OutputFilename;
-        if (outputFile.empty()) {
-            outputFile = InputFilename + ".o";
+        // Every requested format comes out of one codegen session; without an
+        // explicit flag the output file's extension decides
+        std::vector<OutputFormat> formats;
+        if (EmitIR) formats.push_back(OutputFormat::LLVM_IR);
+        if (EmitBitcode) formats.push_back(OutputFormat::Bitcode);
+        if (EmitAssembly) formats.push_back(OutputFormat::Assembly);
+        if (EmitObject) formats.push_back(OutputFormat::Object);
+        if (formats.empty()) {
+            formats.push_back(CodegenAgent::formatForFilename(outputFile));
+        }
+        if (emitLibrary && std::find(formats.begin(), formats.end(), OutputFormat::Object) == formats.end()) {
+            formats.push_back(OutputFormat::Object);
         }
         
-        if (EmitIR || outputFile.find(".ll") != std::string::npos) {
-            codegenAgent.emitIRFile(module, outputFile);
-            hasOutput = true;
-        } else if (EmitAssembly || outputFile.find(".s") != std::string::npos) {
-            codegenAgent.emitAssemblyFile(module, outputFile);
-            hasOutput = true;
-        } else if (EmitBitcode || outputFile.find(".bc") != std::string::npos) {
-            codegenAgent.emitBitcodeFile(module, outputFile);
-            hasOutput = true;
-        } else if (EmitObject || outputFile.find(".o") != std::string::npos) {
-            codegenAgent.emitObjectFile(module, outputFile);
-            hasOutput = true;
+        std::string objectFile;
+        std::vector<std::pair<OutputFormat, std::string>> outputs;
+        for (OutputFormat format : formats) {
+            std::string filename = formats.size() == 1
+                ? outputFile
+                : CodegenAgent::filenameForFormat(outputFile, format);
+            if (format == OutputFormat::Object) {
+                if (emitLibrary) {
+                    filename = libraryBase + ".o";
+                }
+                objectFile = filename;
+            }
+            outputs.push_back({format, filename});
+        }
+        
+        // Assembly alone leaves nothing for the JIT to load, so it gets an object of its own
+        if (RunJIT && emitsMachineCode && objectFile.empty()) {
+            llvm::SmallString<128> path;
+            if (std::error_code EC = llvm::sys::fs::createTemporaryFile("dsl-jit", "o", path)) {
+                diagnostics.addDiagnostic(Diagnostic::Error, "Cannot create an object file for the JIT: " + EC.message());
+                diagnostics.printDiagnostics();
+                return 1;
+            }
+            jitObjectFile = std::string(path);
+            outputs.push_back({OutputFormat::Object, jitObjectFile});
+        }
+        
+        // With -j the object comes out as one partition per thread
+        std::vector<std::string> objects;
+        if (!codegenAgent.emitOutputs(module, outputs, objects, CodegenThreads)) {
+            diagnostics.addDiagnostic(Diagnostic::Error, "Code generation failed for " + outputFile);
+            diagnostics.printDiagnostics();
+            return 1;
+        }
+        
+        if (!objectFile.empty()) {
+            // Linking consumes the partitions directly; otherwise merge them into one object
+            if (CodegenThreads > 1 && !Link && !emitLibrary) {
+                if (!LinkerAgent::linkRelocatable(objects, objectFile)) {
+                    diagnostics.addDiagnostic(Diagnostic::Error, "Cannot merge object partitions into " + objectFile);
+                    diagnostics.printDiagnostics();
+                    return 1;
+                }
+                for (const auto& part : objects) {
+                    llvm::sys::fs::remove(part);
+                }
+                objects = {objectFile};
+            }
+            
+            std::string orderFile;
+            if (splitHotCold && codegenAgent.emitSymbolOrderingFile(module, objectFile + ".order")) {
+                orderFile = objectFile + ".order";
+            }
+            
+            if (cacheable && objects.size() == 1 && !diagnostics.hasErrors()) {
+                compileCache->store(cacheKey, objectFile);
+                compileCache->prune();
+            }
             
             // Agent 10: Linker Agent
             if (Link) {
+                linkExecutable(objects, objectFile, orderFile, benchIterations() > 0 && !RunJIT);
+            }
+            
+            if (emitLibrary) {
                 LOG_INFO("\n[Agent 10] Linker Agent");
-                std::vector<std::string> objects = {outputFile};
-                std::string exeFile = outputFile;
-                if (exeFile.find(".o") != std::string::npos) {
-                    exeFile.replace(exeFile.find(".o"), 2, "");
+                StageTimer::begin("Linker");
+                if (EmitShared) {
+                    #ifdef __APPLE__
+                        std::string libraryFile = libraryBase + ".dylib";
+                    #else
+                        std::string libraryFile = libraryBase + ".so";
+                    #endif
+                    if (!LinkerAgent::linkShared(objects, libraryFile)) {
+                        diagnostics.addDiagnostic(Diagnostic::Error, "Failed to link shared library " + libraryFile);
+                    }
                 }
-                exeFile += ".out";
-                
-                // Try lld first, fall back to system linker
-                if (!LinkerAgent::linkWithLLD(objects, exeFile)) {
-                    LOG_WARNING("lld not available, trying system linker");
-                    LinkerAgent::linkWithSystemLinker(objects, exeFile);
+                if (EmitStatic && !LinkerAgent::createStaticArchive(objects, libraryBase + ".a")) {
+                    diagnostics.addDiagnostic(Diagnostic::Error, "Failed to create static archive " + libraryBase + ".a");
                 }
+                codegenAgent.emitCHeader(module, libraryBase + ".h");
             }
         }
+        
+        if (RunJIT) {
+            emittedObjects = objects;
+        }
     }
     
     // Agent 11: JIT Agent
     if (RunJIT) {
         LOG_INFO("\n[Agent 11] JIT Agent");
-        JITAgent jitAgent;
+        StageTimer::begin("JIT");
+        // Baseline code of the tiered JIT embeds run-specific addresses, so it is never cached
+        if (compileCache && !tieredJIT && emittedObjects.empty()) {
+            jitCache = std::make_unique<JITCacheAgent>(*compileCache, cacheFlags);
+            jitAgent.setObjectCache(jitCache.get());
+        }
+        if (lazyJIT) {
+            jitAgent.setLazy(true, deferOptimization && !NoOptimize ? static_cast<int>(OptLevel) : 0);
+        } else if (tieredJIT) {
+            jitAgent.setTiered(std::max(1u, static_cast<unsigned>(TierUpThreshold)));
+        }
+        jitAgent.setCompileThreads(JITThreads);
+        jitAgent.setPerfMap(JITPerfMap);
+        jitAgent.setDebuggerSupport(JITDebug);
         if (jitAgent.initialize()) {
-            // Create a copy of the module for JIT
-            auto moduleCopy = llvm::CloneModule(*module);
-            if (jitAgent.addModule(std::move(moduleCopy))) {
+            // Run the objects codegen already produced; otherwise the JIT takes
+            // the module and its context (nothing below uses the IR again)
+            bool added;
+            std::vector<std::string> warmUp;
+            if (!emittedObjects.empty()) {
+                added = true;
+                for (const auto& object : emittedObjects) {
+                    added = added && jitAgent.addObjectFile(object);
+                    if (!jitObjectFile.empty()) {
+                        llvm::sys::fs::remove(object);
+                    }
+                }
+            } else {
+                // With compile threads, request every function in one lookup so the
+                // partitions compile concurrently before main() runs
+                if (JITThreads > 1 && !lazyJIT && !tieredJIT) {
+                    for (const auto& func : *module) {
+                        if (!func.isDeclaration() && func.hasExternalLinkage()) {
+                            warmUp.push_back(func.getName().str());
+                        }
+                    }
+                }
+                // Cached function bodies live in the same context and must go first
+                incrementalAgent.reset();
+                added = jitAgent.addModule(llvm::orc::ThreadSafeModule(std::move(linkedModule), std::move(contextOwner)));
+            }
+            module = nullptr;
+            if (added) {
                 LOG_INFO("JIT Agent: Module loaded successfully");
+                if (!warmUp.empty()) {
+                    jitAgent.getFunctionAddresses(warmUp);
+                }
+                
+                // Run --entry, or else main()
+                void* mainFunc = entrySignature ? nullptr : jitAgent.getFunctionAddress("main");
                 
-                // Try to find and execute main function
-                void* mainFunc = jitAgent.getFunctionAddress("main");
-                if (mainFunc) {
+                // Agent 20: Perf Counter Agent
+                std::unique_ptr<PerfCounterAgent> counters;
+                if (PerfStat) {
+                    LOG_INFO("\n[Agent 20] Perf Counter Agent");
+                    counters = std::make_unique<PerfCounterAgent>();
+                    if (!counters->open()) {
+                        diagnostics.addDiagnostic(Diagnostic::Warning, "--perf-stat: no hardware counters available");
+                        counters.reset();
+                    }
+                }
+                
+                // Agent 21: Specialization Agent
+                // A specialization of --entry replaces it; --args then lists only the free parameters
+                const SpecializationAgent::Specialization* entrySpecialization = nullptr;
+                if (specializer) {
+                    LOG_INFO("\n[Agent 21] Specialization Agent");
+                    StageTimer::begin("Specialization");
+                    for (const auto& request : Specialize) {
+                        std::string function;
+                        std::vector<std::pair<std::string, std::string>> constants;
+                        if (!SpecializationAgent::parseRequest(request, function, constants)) {
+                            diagnostics.addDiagnostic(Diagnostic::Error, "Invalid --specialize " + request);
+                            continue;
+                        }
+                        auto* specialization = specializer->specialize(function, constants);
+                        if (!specialization) {
+                            diagnostics.addDiagnostic(Diagnostic::Error, "Failed to specialize " + request);
+                        } else if (function == Entry) {
+                            entrySpecialization = specialization;
+                        }
+                    }
+                }
+                
+                bool executed = false;
+                if (entrySignature) {
+                    // Agent 18: Batch Agent
+                    LOG_INFO("\n[Agent 18] Batch Agent");
+                    auto entry = jitAgent.getFunction<EntryTrampoline>(InvocationAgent::trampolineName(Entry));
+                    const ast::Function* signature = entrySignature.get();
+                    if (entrySpecialization) {
+                        entry = entrySpecialization->entry;
+                        signature = entrySpecialization->signature.get();
+                    }
+                    StageTimer::begin("JIT run");
+                    executed = entry && runEntry(entry, *signature, counters.get());
+                    StageTimer::end();
+                    if (!executed) {
+                        diagnostics.addDiagnostic(Diagnostic::Error, "Failed to run " + Entry);
+                    }
+                } else if (mainFunc) {
                     typedef int (*MainFunc)();
                     MainFunc main = reinterpret_cast<MainFunc>(mainFunc);
-                    LOG_INFO("Executing main() via JIT...");
-                    int result = main();
-                    LOG_INFO("Program returned: " + std::to_string(result));
+                    if (unsigned iterations = benchIterations()) {
+                        LOG_INFO("\n[Agent 19] Benchmark Agent");
+                        StageTimer::begin("Benchmark");
+                        int result = 0;
+                        BenchmarkAgent benchAgent(iterations, BenchWarmup);
+                        benchAgent.setCounters(counters.get());
+                        reportBenchmark(benchAgent.measure("main", [&] {
+                            result = main();
+                            BenchmarkAgent::doNotOptimize(&result);
+                        }));
+                        StageTimer::end();
+                        if (counters) {
+                            counters->report("main", iterations);
+                        }
+                    } else {
+                        LOG_INFO("Executing main() via JIT...");
+                        StageTimer::begin("JIT run");
+                        if (counters) counters->start();
+                        int result = main();
+                        if (counters) counters->stop();
+                        StageTimer::end();
+                        LOG_INFO("Program returned: " + std::to_string(result));
+                        if (counters) {
+                            counters->report("main", 1);
+                        }
+                    }
+                    executed = true;
                 } else {
                     LOG_WARNING("No main() function found for JIT execution");
                 }
+                
+                if (executed && ProfileGenerate) {
+                    auto dumpProfile = jitAgent.getFunction<void (*)()>(ProfileAgent::DumpFunctionName);
+                    if (dumpProfile) {
+                        dumpProfile();
+                        LOG_INFO("Profile written to " + ProfileOutput);
+                    }
+                }
             }
         }
+        if (jitCache) {
+            // Lazy partitions compile during the run, so the counts are final only now
+            StageTimer::note("JIT", std::to_string(jitCache->getHits()) + " cached, " +
+                                    std::to_string(jitCache->getMisses()) + " compiled object(s)");
+            compileCache->prune();
+        }
     }
     
     diagnostics.printDiagnostics();
+    StageTimer::report();
+    
+    if (compileCache && CacheStatsFlag) {
+        compileCache->printStats();
+    }
     
     if (diagnostics.hasErrors()) {
         LOG_ERROR("Compilation failed with " + std::to_string(diagnostics.errorCount()) + " error(s)");
@@ -3,6 +3,7 @@
 #include <iomanip>
 #include <chrono>
 #include <ctime>
+#include <mutex>
 
 void Logger::log(LogLevel level, const std::string& message) {
     auto now = std::chrono::system_clock::now();
@@ -24,6 +25,9 @@ void Logger::log(LogLevel level, const std::string& message) {
             break;
     }
     
+    // Agents may log from worker threads; keep lines intact
+    static std::mutex outputMutex;
+    std::lock_guard<std::mutex> lock(outputMutex);
     std::cout << prefix << " " << message << std::endl;
 }
 
@@ -0,0 +1,119 @@
+#include "utils/StageTimer.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Stage {
+    std::string name;
+    std::chrono::steady_clock::duration elapsed{};
+    std::string note;
+};
+
+struct TimerState {
+    std::mutex mutex;
+    bool enabled = false;
+    std::vector<Stage> stages;
+    size_t current = 0;
+    bool running = false;
+    std::chrono::steady_clock::time_point started;
+    
+    void stop() {
+        if (running) {
+            stages[current].elapsed += std::chrono::steady_clock::now() - started;
+            running = false;
+        }
+    }
+};
+
+TimerState& state() {
+    static TimerState timers;
+    return timers;
+}
+
+} // namespace
+
+void StageTimer::setEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    state().enabled = enabled;
+}
+
+bool StageTimer::isEnabled() {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().enabled;
+}
+
+void StageTimer::begin(const std::string& stage) {
+    TimerState& timers = state();
+    std::lock_guard<std::mutex> lock(timers.mutex);
+    if (!timers.enabled) return;
+    
+    timers.stop();
+    size_t index = 0;
+    while (index < timers.stages.size() && timers.stages[index].name != stage) {
+        index++;
+    }
+    if (index == timers.stages.size()) {
+        timers.stages.push_back({stage});
+    }
+    timers.current = index;
+    timers.running = true;
+    timers.started = std::chrono::steady_clock::now();
+}
+
+void StageTimer::end() {
+    std::lock_guard<std::mutex> lock(state().mutex);
+    state().stop();
+}
+
+void StageTimer::note(const std::string& text) {
+    TimerState& timers = state();
+    std::lock_guard<std::mutex> lock(timers.mutex);
+    if (!timers.enabled || timers.stages.empty()) return;
+    timers.stages[timers.current].note = text;
+}
+
+void StageTimer::note(const std::string& stage, const std::string& text) {
+    TimerState& timers = state();
+    std::lock_guard<std::mutex> lock(timers.mutex);
+    if (!timers.enabled) return;
+    for (auto& entry : timers.stages) {
+        if (entry.name == stage) {
+            entry.note = text;
+        }
+    }
+}
+
+void StageTimer::report() {
+    TimerState& timers = state();
+    std::lock_guard<std::mutex> lock(timers.mutex);
+    if (!timers.enabled) return;
+    timers.stop();
+    
+    std::chrono::steady_clock::duration total{};
+    for (const auto& stage : timers.stages) {
+        total += stage.elapsed;
+    }
+    
+    auto millis = [](std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    
+    std::cout << "\n=== Stage Times ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (const auto& stage : timers.stages) {
+        std::cout << std::left << std::setw(22) << stage.name << std::right << std::setw(12)
+                  << millis(stage.elapsed) << " ms";
+        if (!stage.note.empty()) {
+            std::cout << "  (" << stage.note << ")";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << std::left << std::setw(22) << "Total" << std::right << std::setw(12) << millis(total) << " ms"
+              << std::endl;
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout << std::setprecision(6);
+}
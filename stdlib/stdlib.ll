@@ -0,0 +1,240 @@
+; DSL standard library.
+;
+; Assembled to bitcode at build time and embedded in the compiler. Modules load
+; it lazily and link with LinkOnlyNeeded, so only the functions a program calls
+; are materialized. Everything is linkonce_odr: each input module may carry its
+; own copy and the linker keeps one.
+;
+; Only functions whose signatures use DSL types (i32, i64, float, double, i1)
+; are visible to DSL programs.
+
+; --- Integer helpers ---------------------------------------------------------
+
+define linkonce_odr i32 @abs_i32(i32 %x) #0 {
+entry:
+  %r = call i32 @llvm.abs.i32(i32 %x, i1 false)
+  ret i32 %r
+}
+
+define linkonce_odr i64 @abs_i64(i64 %x) #0 {
+entry:
+  %r = call i64 @llvm.abs.i64(i64 %x, i1 false)
+  ret i64 %r
+}
+
+define linkonce_odr i32 @min_i32(i32 %a, i32 %b) #0 {
+entry:
+  %r = call i32 @llvm.smin.i32(i32 %a, i32 %b)
+  ret i32 %r
+}
+
+define linkonce_odr i32 @max_i32(i32 %a, i32 %b) #0 {
+entry:
+  %r = call i32 @llvm.smax.i32(i32 %a, i32 %b)
+  ret i32 %r
+}
+
+define linkonce_odr i64 @min_i64(i64 %a, i64 %b) #0 {
+entry:
+  %r = call i64 @llvm.smin.i64(i64 %a, i64 %b)
+  ret i64 %r
+}
+
+define linkonce_odr i64 @max_i64(i64 %a, i64 %b) #0 {
+entry:
+  %r = call i64 @llvm.smax.i64(i64 %a, i64 %b)
+  ret i64 %r
+}
+
+define linkonce_odr i32 @clamp_i32(i32 %x, i32 %lo, i32 %hi) #0 {
+entry:
+  %low = call i32 @llvm.smax.i32(i32 %x, i32 %lo)
+  %r = call i32 @llvm.smin.i32(i32 %low, i32 %hi)
+  ret i32 %r
+}
+
+define linkonce_odr i64 @clamp_i64(i64 %x, i64 %lo, i64 %hi) #0 {
+entry:
+  %low = call i64 @llvm.smax.i64(i64 %x, i64 %lo)
+  %r = call i64 @llvm.smin.i64(i64 %low, i64 %hi)
+  ret i64 %r
+}
+
+; base^exp by repeated squaring; negative exponents give 0
+define linkonce_odr i64 @pow_i64(i64 %base, i64 %exp) #0 {
+entry:
+  %negative = icmp slt i64 %exp, 0
+  br i1 %negative, label %zero, label %header
+
+zero:
+  ret i64 0
+
+header:
+  %result = phi i64 [ 1, %entry ], [ %result.next, %body ]
+  %b = phi i64 [ %base, %entry ], [ %b.next, %body ]
+  %e = phi i64 [ %exp, %entry ], [ %e.next, %body ]
+  %more = icmp ne i64 %e, 0
+  br i1 %more, label %body, label %exit
+
+body:
+  %bit = and i64 %e, 1
+  %odd = icmp ne i64 %bit, 0
+  %product = mul i64 %result, %b
+  %result.next = select i1 %odd, i64 %product, i64 %result
+  %b.next = mul i64 %b, %b
+  %e.next = lshr i64 %e, 1
+  br label %header
+
+exit:
+  ret i64 %result
+}
+
+define linkonce_odr i64 @gcd_i64(i64 %a, i64 %b) #0 {
+entry:
+  %a.abs = call i64 @llvm.abs.i64(i64 %a, i1 false)
+  %b.abs = call i64 @llvm.abs.i64(i64 %b, i1 false)
+  br label %header
+
+header:
+  %x = phi i64 [ %a.abs, %entry ], [ %y, %body ]
+  %y = phi i64 [ %b.abs, %entry ], [ %r, %body ]
+  %done = icmp eq i64 %y, 0
+  br i1 %done, label %exit, label %body
+
+body:
+  %r = urem i64 %x, %y
+  br label %header
+
+exit:
+  ret i64 %x
+}
+
+; --- Reductions over integer ranges -----------------------------------------
+
+; lo + (lo + 1) + ... + (hi - 1); 0 for an empty range
+define linkonce_odr i64 @sum_range_i64(i64 %lo, i64 %hi) #0 {
+entry:
+  br label %header
+
+header:
+  %i = phi i64 [ %lo, %entry ], [ %i.next, %body ]
+  %sum = phi i64 [ 0, %entry ], [ %sum.next, %body ]
+  %more = icmp slt i64 %i, %hi
+  br i1 %more, label %body, label %exit
+
+body:
+  %sum.next = add i64 %sum, %i
+  %i.next = add i64 %i, 1
+  br label %header
+
+exit:
+  ret i64 %sum
+}
+
+; lo * (lo + 1) * ... * (hi - 1); 1 for an empty range
+define linkonce_odr i64 @product_range_i64(i64 %lo, i64 %hi) #0 {
+entry:
+  br label %header
+
+header:
+  %i = phi i64 [ %lo, %entry ], [ %i.next, %body ]
+  %product = phi i64 [ 1, %entry ], [ %product.next, %body ]
+  %more = icmp slt i64 %i, %hi
+  br i1 %more, label %body, label %exit
+
+body:
+  %product.next = mul i64 %product, %i
+  %i.next = add i64 %i, 1
+  br label %header
+
+exit:
+  ret i64 %product
+}
+
+define linkonce_odr i64 @factorial_i64(i64 %n) #0 {
+entry:
+  %hi = add i64 %n, 1
+  %r = call i64 @product_range_i64(i64 1, i64 %hi)
+  ret i64 %r
+}
+
+; --- Floating point ----------------------------------------------------------
+
+define linkonce_odr double @abs_f64(double %x) #0 {
+entry:
+  %r = call double @llvm.fabs.f64(double %x)
+  ret double %r
+}
+
+define linkonce_odr double @min_f64(double %a, double %b) #0 {
+entry:
+  %r = call double @llvm.minnum.f64(double %a, double %b)
+  ret double %r
+}
+
+define linkonce_odr double @max_f64(double %a, double %b) #0 {
+entry:
+  %r = call double @llvm.maxnum.f64(double %a, double %b)
+  ret double %r
+}
+
+define linkonce_odr double @clamp_f64(double %x, double %lo, double %hi) #0 {
+entry:
+  %low = call double @llvm.maxnum.f64(double %x, double %lo)
+  %r = call double @llvm.minnum.f64(double %low, double %hi)
+  ret double %r
+}
+
+define linkonce_odr double @sqrt_f64(double %x) #0 {
+entry:
+  %r = call double @llvm.sqrt.f64(double %x)
+  ret double %r
+}
+
+define linkonce_odr double @floor_f64(double %x) #0 {
+entry:
+  %r = call double @llvm.floor.f64(double %x)
+  ret double %r
+}
+
+define linkonce_odr double @ceil_f64(double %x) #0 {
+entry:
+  %r = call double @llvm.ceil.f64(double %x)
+  ret double %r
+}
+
+define linkonce_odr double @fma_f64(double %a, double %b, double %c) #0 {
+entry:
+  %r = call double @llvm.fma.f64(double %a, double %b, double %c)
+  ret double %r
+}
+
+define linkonce_odr float @sqrt_f32(float %x) #0 {
+entry:
+  %r = call float @llvm.sqrt.f32(float %x)
+  ret float %r
+}
+
+define linkonce_odr float @abs_f32(float %x) #0 {
+entry:
+  %r = call float @llvm.fabs.f32(float %x)
+  ret float %r
+}
+
+declare i32 @llvm.abs.i32(i32, i1 immarg)
+declare i64 @llvm.abs.i64(i64, i1 immarg)
+declare i32 @llvm.smin.i32(i32, i32)
+declare i32 @llvm.smax.i32(i32, i32)
+declare i64 @llvm.smin.i64(i64, i64)
+declare i64 @llvm.smax.i64(i64, i64)
+declare double @llvm.fabs.f64(double)
+declare double @llvm.minnum.f64(double, double)
+declare double @llvm.maxnum.f64(double, double)
+declare double @llvm.sqrt.f64(double)
+declare double @llvm.floor.f64(double)
+declare double @llvm.ceil.f64(double)
+declare double @llvm.fma.f64(double, double, double)
+declare float @llvm.sqrt.f32(float)
+declare float @llvm.fabs.f32(float)
+
+attributes #0 = { nounwind willreturn memory(none) }